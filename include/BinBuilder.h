@@ -0,0 +1,89 @@
+/*
+ * BinBuilder.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef BINBUILDER_H_
+#define BINBUILDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "bs_data.h"
+#include "BinStream.h"
+
+namespace BS
+{
+    /**
+     * Typed builder writing values straight to the output of a BinStream,
+     * without formatting nor parsing any text. The numbers use the current
+     * endianess of the stream unless one is given, and the endianess
+     * switches change the mode of the stream, so text and typed values can be
+     * mixed. The bytes are the ones of the equivalent description, e.g.
+     * u16(0x0011) is `%x0011` and f64(1.5) is `%f1.5[8]`.
+     *
+     *     BinBuilder(b).big_endian().u16(0x0011).i32(-2).str("abc");
+     */
+    class BinBuilder
+    {
+    private:
+        BinStream & m_stream;
+
+        BinBuilder& number(uint64_t value, int size, bool num_signed,
+                endianess_t endianess);
+
+    public:
+        BinBuilder(BinStream & stream);
+
+        // Mode switches
+        BinBuilder& endianess(endianess_t endianess);
+        BinBuilder& big_endian(void);
+        BinBuilder& little_endian(void);
+
+        // Numbers in the current endianess of the stream
+        BinBuilder& u8(uint8_t value);
+        BinBuilder& u16(uint16_t value);
+        BinBuilder& u32(uint32_t value);
+        BinBuilder& u64(uint64_t value);
+        BinBuilder& i8(int8_t value);
+        BinBuilder& i16(int16_t value);
+        BinBuilder& i32(int32_t value);
+        BinBuilder& i64(int64_t value);
+        BinBuilder& f32(float32_t value);
+        BinBuilder& f64(float64_t value);
+
+        // Numbers in a given endianess
+        BinBuilder& u16(uint16_t value, endianess_t endianess);
+        BinBuilder& u32(uint32_t value, endianess_t endianess);
+        BinBuilder& u64(uint64_t value, endianess_t endianess);
+        BinBuilder& i16(int16_t value, endianess_t endianess);
+        BinBuilder& i32(int32_t value, endianess_t endianess);
+        BinBuilder& i64(int64_t value, endianess_t endianess);
+        BinBuilder& f32(float32_t value, endianess_t endianess);
+        BinBuilder& f64(float64_t value, endianess_t endianess);
+
+        // LEB128 numbers, one or many per call
+        BinBuilder& uleb128(uint64_t value);
+        BinBuilder& sleb128(int64_t value);
+        BinBuilder& uleb128(const uint64_t *values, size_t count);
+        BinBuilder& sleb128(const int64_t *values, size_t count);
+
+        // Raw bytes and strings
+        BinBuilder& bytes(const void *data, size_t size);
+        BinBuilder& bytes(const std::vector<char> & data);
+        BinBuilder& str(const char *s);
+        BinBuilder& str(const std::string & s);
+
+        // Repeated bytes, written without being expanded first
+        BinBuilder& fill(uint64_t count, uint8_t value=0);
+        BinBuilder& repeat(const void *data, size_t size, uint64_t count);
+        BinBuilder& align(uint64_t alignment, uint8_t value=0);
+        BinBuilder& pad_to(uint64_t offset, uint8_t value=0);
+    };
+}
+
+#endif /* BINBUILDER_H_ */
@@ -9,45 +9,112 @@
 #ifndef BINSTREAM_H_
 #define BINSTREAM_H_
 
+#include <map>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "bs_checksum.h"
 #include "bs_data.h"
 #include "bs_exception.h"
+#include "bs_program.h"
+#include "bs_sink.h"
 
 namespace BS
 {
+    /**
+     * Reference or checksum written before it can be computed. Its placeholder
+     * is patched once it can.
+     */
+    typedef struct
+    {
+        uint64_t position; /** offset of the placeholder in the output */
+        std::string label; /** the label of a checksum start */
+        std::string base;  /** empty if the reference is an offset, the label
+                               of a checksum end */
+        int size;
+        endianess_t endianess;
+        bool checksum;     /** a checksum of the output between the labels */
+        checksum_type_t algorithm; /** set if checksum */
+    } fixup_t;
+
+    /** Label with the checksums of the output from the first label to it */
+    typedef struct
+    {
+        uint64_t position;
+        Checksums checksums;
+    } label_t;
+
+    /** Placeholder bytes patched in the output */
+    typedef struct
+    {
+        uint64_t position;
+        size_t size;
+        char data[8];
+    } patch_t;
+
     class BinStream
     {
     private:
         std::stringstream m_input; // the input string to convert to binary
         std::vector<char> m_output; // the output binary data to generate
+        VectorSink m_output_sink; // the default sink writing to m_output
+        Sink *m_sink; // the sink receiving the generated data
+        ProgramSink *m_recorder; // if compiling, records the mode changes
 
         endianess_t m_curr_endianess;
         type_t m_curr_numbers;
         int m_curr_size;
+        uint64_t m_repeat; // number of times to write the next value (1 if none)
+        uint64_t m_position; // number of bytes generated since the output reset
+        std::unordered_map<std::string, label_t> m_labels;
+        std::map<uint64_t, fixup_t> m_fixups; // references and checksums not computed yet, by offset
+        std::unordered_map<std::string, std::vector<uint64_t> > m_waiting; // offsets of the fixups waiting for each label
+        std::unordered_map<uint64_t, std::vector<uint64_t> > m_blocked; // offsets of the checksums waiting for each placeholder
+        Checksums m_checksums; // checksums of the output from the first label
+        std::map<uint64_t, patch_t> m_patches; // patches not in the label checksums, by offset
 
         bool m_input_ready;
         bool m_output_ready;
 
         bool m_verbose;
+        bool m_keep_input; // keep the raw input text in m_input
+        size_t m_errors; // number of elements in error since the last reset
 
     public:
+        static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+        static const size_t PARALLEL_CHUNK_SIZE = 1024 * 1024;
+
         BinStream(bool verbose=false);
         BinStream(const BinStream& o);
+        BinStream(BinStream&& o);
         ~BinStream();
 
+        BinStream& operator=(BinStream&& o);
+
         void reset(void);
         void reset_modes(void);
         void reset_output(void);
         void reset_input(void);
+        void copy_modes(const BinStream & o);
 
         void set_verbosity(bool verbose);
+        void set_keep_input(bool keep);
+        void set_sink(Sink *sink);
+        Sink& sink(void) const;
+        void set_endianess(endianess_t endianess);
+        endianess_t endianess(void) const;
 
         bool input_ready(void) const;
         bool output_ready(void) const;
+        size_t errors(void) const;
+        uint64_t position(void) const;
+        size_t unresolved(void) const;
+        void check_references(void) const;
         bool get_output(std::vector<char>& output) const;
+        std::vector<char> take_output(void);
+        const char* data(void) const;
         size_t size(void) const;
 
         char operator[](const size_t index) const;
@@ -60,16 +127,64 @@ namespace BS
         BinStream& operator>>(std::ofstream & f);
         BinStream& operator>>(std::vector<char> & output);
 
+        // Size of the output without generating it
+        uint64_t measure(const char *data, size_t size);
+        uint64_t measure(const std::string & desc);
+        uint64_t measure(std::istream & in);
+
+        // Compilation of a description to a program replayed without parsing
+        Program compile(const char *data, size_t size) const;
+        Program compile(const std::string & desc) const;
+        Program compile(std::istream & in) const;
+        BinStream& run(const Program & program);
+
+        // Streaming conversion with bounded memory
+        bool stream(std::istream & in, Sink & out,
+                size_t chunk_size=DEFAULT_CHUNK_SIZE);
+        bool stream(std::istream & in, std::ostream & out,
+                size_t chunk_size=DEFAULT_CHUNK_SIZE);
+
+        // Parallel conversion of a large description
+        void proceed_parallel(const char *data, size_t size, size_t threads=0,
+                size_t chunk_size=PARALLEL_CHUNK_SIZE);
+
         friend std::ostream& operator<<(std::ostream& stream, const BinStream& bin_stream);
         friend std::istream& operator>>(std::istream& stream, BinStream& bin_stream);
 
         // Low-level functions for parsing input and generating output
         bool update_internal_state(const std::string & element);
+        bool update_internal_state(const char *element, size_t size);
         void proceed_input(const std::string & element);
+        void proceed_input(const char *data, size_t size);
+        bool proceed_file(const std::string & path);
+        void proceed_chunks(std::streambuf *buf, size_t chunk_size);
+        void proceed_chunk(const char *data, size_t size, std::string & pending);
+        void proceed_line(const char *line, size_t size);
+        bool proceed_hex_line(const char *line, size_t size);
+        void emit(const char *data, size_t size);
+        void emit_number(const number_t & number);
+        void emit_fill(const char *pattern, size_t size, uint64_t count);
+        void emit_leb128s(const uint64_t *values, size_t count, bool is_signed);
+        bool emit_align(uint64_t alignment, char padding=0);
+        bool emit_padding(uint64_t offset, char padding=0);
+        void emit_reference(const char *element, size_t size, uint64_t count=1);
+        void emit_checksum(const char *element, size_t size, uint64_t count=1);
+        void define_label(const char *name, size_t size);
         void workflow(const std::string & element);
+        void workflow(const char *element, size_t size);
 
         void bs_log(std::string msg);
         void bs_error(std::string msg);
+
+    private:
+        void emit_fixup(const fixup_t & ref, const char *element, size_t size, uint64_t count);
+        bool reference_value(const fixup_t & ref, uint64_t & value);
+        bool pending_fixup(uint64_t start, uint64_t end, uint64_t except,
+                uint64_t & position) const;
+        void wait_fixup(const fixup_t & ref);
+        void resolve_fixups(std::vector<uint64_t> & offsets);
+        void reference_bytes(const fixup_t & ref, uint64_t value, std::vector<char> & bytes);
+        void patch_output(uint64_t position, const std::vector<char> & bytes);
     };
 }
 
@@ -0,0 +1,48 @@
+/*
+ * bs_checksum.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef BS_CHECKSUM_H_
+#define BS_CHECKSUM_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bs_data.h"
+
+namespace BS
+{
+    // Checksums of a buffer continuing a previous value (0 for the CRCs and 1
+    // for Adler-32 on the first call), as zlib computes them.
+    uint32_t crc32(uint32_t crc, const char *data, size_t size);
+    uint32_t crc32c(uint32_t crc, const char *data, size_t size);
+    uint32_t adler32(uint32_t adler, const char *data, size_t size);
+
+    /**
+     * CRC-32, CRC-32C and Adler-32 of a sequence of bytes, computed together.
+     * The checksums of a part of the sequence are derived from the checksums
+     * of two prefixes, and the bytes of the sequence can be changed afterwards
+     * without going through the sequence again.
+     */
+    class Checksums
+    {
+    private:
+        uint32_t m_crc32;
+        uint32_t m_crc32c;
+        uint32_t m_adler32;
+
+    public:
+        Checksums(void);
+
+        void update(const char *data, size_t size);
+        void update(const char *pattern, size_t size, uint64_t count);
+        void patch(const char *data, size_t size, uint64_t after);
+        Checksums suffix(const Checksums & prefix, uint64_t size) const;
+        uint32_t value(checksum_type_t type) const;
+    };
+}
+
+#endif /* BS_CHECKSUM_H_ */
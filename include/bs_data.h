@@ -17,13 +17,21 @@ typedef double float64_t;
 
 namespace BS
 {
+    // Version of the description grammar. Increase it on any change of the
+    // grammar or of the output of a description: it salts the binmake cache.
+    const int GRAMMAR_VERSION = 1;
+
     typedef enum
     {
         t_state_type_string,
         t_state_type_number,
         t_state_type_size,
         t_state_type_endianess,
-        t_state_type_error
+        t_state_type_error,
+        t_state_type_repeat,
+        t_state_type_fill,
+        t_state_type_align,
+        t_state_type_pad
     } state_type_t;
 
     typedef enum
@@ -36,9 +44,21 @@ namespace BS
         t_string,
         t_internal_state,
         t_none,
-        t_error
+        t_error,
+        t_label,
+        t_reference,
+        t_checksum,
+        t_num_uleb128,
+        t_num_sleb128
     } type_t;
 
+    typedef enum
+    {
+        t_checksum_crc32,
+        t_checksum_crc32c,
+        t_checksum_adler32
+    } checksum_type_t;
+
     typedef enum
     {
         little_endian,
@@ -51,6 +71,7 @@ namespace BS
         endianess_t endianess;
         int size; /** size in bytes (0, 1, 2, 4 or 8) */
         bool num_signed;
+        bool num_float; /** value is value_f32 (size 4) or value_f64 (size 8) */
         union
         {
             uint64_t value_u64;
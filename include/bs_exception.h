@@ -1,7 +1,10 @@
 #ifndef BS_EXCEPTION_H_
 #define BS_EXCEPTION_H_
 
+#include <cstddef>
+#include <cstdint>
 #include <exception>
+#include <string>
 
 namespace BS
 {
@@ -43,6 +46,113 @@ namespace BS
             return msg.c_str();
         }
     };
+
+    class BSExceptionSinkFull: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionSinkFull(size_t capacity) throw():
+            msg(std::string("Sink capacity of ") +
+                    std::to_string(capacity) +
+                    std::string(" bytes exceeded.")){}
+        virtual ~BSExceptionSinkFull(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
+
+    class BSExceptionFillTooLarge: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionFillTooLarge(size_t size, uint64_t count) throw():
+            msg(std::string("Cannot fill ") + std::to_string(count) +
+                    std::string(" times ") + std::to_string(size) +
+                    std::string(" bytes, the size overflows.")){}
+        virtual ~BSExceptionFillTooLarge(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
+
+    class BSExceptionWriteFailed: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionWriteFailed(const char *reason) throw():
+            msg(std::string("Failed to write output: ") + reason){}
+        virtual ~BSExceptionWriteFailed(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
+
+    class BSExceptionReadFailed: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionReadFailed(const char *reason) throw():
+            msg(std::string("Failed to read input: ") + reason){}
+        virtual ~BSExceptionReadFailed(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
+
+    class BSExceptionPatchFailed: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionPatchFailed(uint64_t back) throw():
+            msg(std::string("Cannot patch the output ") +
+                    std::to_string(back) +
+                    std::string(" bytes back.")){}
+        virtual ~BSExceptionPatchFailed(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
+
+    class BSExceptionUnresolvedLabel: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionUnresolvedLabel(const std::string & label) throw():
+            msg(std::string("Reference to the undefined label '") +
+                    label + std::string("'.")){}
+        virtual ~BSExceptionUnresolvedLabel(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
+
+    class BSExceptionPendingRepeat: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionPendingRepeat(uint64_t count) throw():
+            msg(std::string("repeat[") + std::to_string(count) +
+                    std::string("] is not followed by a value.")){}
+        virtual ~BSExceptionPendingRepeat(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
+
+    class BSExceptionUnresolvedChecksum: public std::exception
+    {
+        const std::string msg;
+    public:
+        BSExceptionUnresolvedChecksum(const std::string & start,
+                const std::string & end) throw():
+            msg(std::string("Checksum from the label '") + start +
+                    std::string("' to the label '") + end +
+                    std::string("' depends on itself.")){}
+        virtual ~BSExceptionUnresolvedChecksum(void) throw() {}
+        virtual const char *what(void) const throw() {
+            return msg.c_str();
+        }
+    };
 }
 
 #endif //BS_EXCEPTION_H_
@@ -0,0 +1,900 @@
+/*
+ * bs_literal.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef BS_LITERAL_H_
+#define BS_LITERAL_H_
+
+#if __cplusplus < 201402L
+#error "bs_literal.h requires C++14 (constexpr functions with loops)"
+#endif
+
+#include <array>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "bs_data.h"
+
+namespace BS
+{
+/**
+ * Compile-time conversion of descriptions. The grammar, the modes and the
+ * sizing rules are the ones of BinStream and extract_number(), so
+ * "big-endian 0011 %d42[4] 'abc'"_bin is a std::array<uint8_t, N> holding the
+ * bytes BinStream generates from the same description.
+ * A float is converted at compile time only when its mantissa and its power
+ * of ten are exactly representable (as the fast path of the run-time
+ * conversion), other floats are rejected. Labels, references and checksums
+ * are not supported.
+ */
+namespace literal
+{
+    // Errors of a description. They are not constexpr, so reaching one while
+    // a literal is evaluated at compile time is a compile error naming the
+    // problem, with the offset of the faulty element in the description as
+    // argument. Evaluated at run time, they raise std::invalid_argument.
+
+    inline void malformed_element(size_t offset)
+    {
+        throw std::invalid_argument("Malformed element at offset " + std::to_string(offset));
+    }
+
+    inline void bad_size(size_t offset)
+    {
+        throw std::invalid_argument("Bad size at offset " + std::to_string(offset) +
+                ". Should be 0, 1, 2, 4 or 8");
+    }
+
+    inline void number_out_of_range(size_t offset)
+    {
+        throw std::invalid_argument("Number out of range at offset " + std::to_string(offset));
+    }
+
+    inline void bad_padding(size_t offset)
+    {
+        throw std::invalid_argument("Bad alignment or padding at offset " +
+                std::to_string(offset));
+    }
+
+    inline void pending_repeat(size_t offset)
+    {
+        throw std::invalid_argument("Repeat not followed by a value at offset " +
+                std::to_string(offset));
+    }
+
+    inline void inexact_float(size_t offset)
+    {
+        throw std::invalid_argument("Float at offset " + std::to_string(offset) +
+                " cannot be converted exactly at compile time");
+    }
+
+    typedef struct
+    {
+        endianess_t endianess;
+        type_t numbers;
+        int size;
+        uint64_t repeat; // number of times to write the next value
+    } modes_t;
+
+    constexpr bool is_space(char c)
+    {
+        return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+    }
+
+    constexpr bool is_digit(char c)
+    {
+        return (c >= '0') && (c <= '9');
+    }
+
+    constexpr int digit_value(char c)
+    {
+        return is_digit(c) ? c - '0' : ((c | 0x20) - 'a' + 10);
+    }
+
+    constexpr bool is_base_digit(char c, int base)
+    {
+        return (base == 16) ? (is_digit(c) || (((c | 0x20) >= 'a') && ((c | 0x20) <= 'f')))
+                : (is_digit(c) && (c - '0' < base));
+    }
+
+    constexpr bool is_valid_size(int size)
+    {
+        return (size == 0) || (size == 1) || (size == 2) || (size == 4) || (size == 8);
+    }
+
+    constexpr bool equals(const char *p, size_t len, const char *keyword)
+    {
+        size_t i = 0;
+
+        while ((i < len) && (keyword[i] != '\0') && (p[i] == keyword[i]))
+        {
+            ++i;
+        }
+        return (i == len) && (keyword[i] == '\0');
+    }
+
+    /**
+     * @brief Parse a bracketed value "[N]" ending at `end`, as
+     * lex_bracket_value() does
+     * @return false if there is no such value
+     */
+    constexpr bool bracket_value(const char *p, const char *end, int & value)
+    {
+        long long v = 0;
+        const char *q = p + 1;
+
+        if ((p >= end) || (*p != '['))
+        {
+            return false;
+        }
+        for (; (q < end) && is_digit(*q); ++q)
+        {
+            v = v * 10 + (*q - '0');
+            v = (v > INT_MAX) ? INT_MAX : v;
+        }
+        if ((q == p + 1) || (q + 1 != end) || (*q != ']'))
+        {
+            return false;
+        }
+        value = (int)v;
+        return true;
+    }
+
+    /**
+     * @brief Parse a bracketed count "[N]" ending at `end`, as
+     * lex_bracket_count() does (a too big count is saturated)
+     * @return false if there is no such count
+     */
+    constexpr bool bracket_count(const char *p, const char *end, uint64_t & count)
+    {
+        uint64_t v = 0;
+        const char *q = p + 1;
+
+        if ((p >= end) || (*p != '['))
+        {
+            return false;
+        }
+        for (; (q < end) && is_digit(*q); ++q)
+        {
+            v = (v > (UINT64_MAX - 9) / 10) ? UINT64_MAX : v * 10 + (*q - '0');
+        }
+        if ((q == p + 1) || (q + 1 != end) || (*q != ']'))
+        {
+            return false;
+        }
+        count = v;
+        return true;
+    }
+
+    /**
+     * @brief Parse a bracketed count with an optional hexadecimal padding byte
+     * "[N]" or "[N,HH]" ending at `end`, as lex_bracket_padding() does
+     * @return false if there is no such count
+     */
+    constexpr bool bracket_padding(const char *p, const char *end, uint64_t & count,
+            uint8_t & padding)
+    {
+        uint64_t v = 0;
+        const char *q = p + 1;
+        const char *hex = p;
+
+        if ((p >= end) || (*p != '['))
+        {
+            return false;
+        }
+        for (; (q < end) && is_digit(*q); ++q)
+        {
+            v = (v > (UINT64_MAX - 9) / 10) ? UINT64_MAX : v * 10 + (*q - '0');
+        }
+        if (q == p + 1)
+        {
+            return false;
+        }
+        padding = 0;
+        if ((q < end) && (*q == ','))
+        {
+            for (hex = ++q; (q < end) && is_base_digit(*q, 16); ++q)
+            {
+                padding = (uint8_t)((padding << 4) | digit_value(*q));
+            }
+            if ((q == hex) || (q - hex > 2))
+            {
+                return false;
+            }
+        }
+        if ((q + 1 != end) || (*q != ']'))
+        {
+            return false;
+        }
+        count = v;
+        return true;
+    }
+
+    /**
+     * @brief Smallest size (1, 2, 4 or 8 bytes) of a number of bits
+     */
+    constexpr int size_of_bits(int bits)
+    {
+        return (bits <= 8) ? 1 : (bits <= 16) ? 2 : (bits <= 32) ? 4 : 8;
+    }
+
+    constexpr int bit_length(uint64_t value)
+    {
+        int bits = 1;
+
+        while ((bits < 64) && ((value >> bits) != 0))
+        {
+            ++bits;
+        }
+        return bits;
+    }
+
+    /**
+     * @brief Encode a float of the fast path range in its IEEE 754 bits. The
+     * value is scaled by powers of 2, which is exact.
+     *
+     * @param value the absolute value (a normal number or 0)
+     * @param mantissa_bits the number of stored mantissa bits (23 or 52)
+     * @param bias the exponent bias (127 or 1023)
+     */
+    template <typename Float>
+    constexpr uint64_t float_bits(Float value, int mantissa_bits, int bias)
+    {
+        int exponent = 0;
+        Float one = 1;
+
+        if (value == 0)
+        {
+            return 0;
+        }
+        for (; value >= 2; value /= 2)
+        {
+            ++exponent;
+        }
+        for (; value < 1; value *= 2)
+        {
+            --exponent;
+        }
+        for (int i = 0; i < mantissa_bits; ++i)
+        {
+            one *= 2;
+        }
+        return ((uint64_t)(exponent + bias) << mantissa_bits) |
+                (uint64_t)((value - 1) * one);
+    }
+
+    /**
+     * @brief Split float characters in a decimal mantissa and exponent, as
+     * split_float() does
+     * @return false if the mantissa has more than 19 significant digits
+     */
+    constexpr bool split_float(const char *p, const char *end, uint64_t & mantissa,
+            int64_t & exponent)
+    {
+        int64_t exp_value = 0;
+        bool exp_negative = false;
+        int count = 0;
+        const char *digits = p;
+
+        mantissa = 0;
+        exponent = 0;
+        p += ((*p == '+') || (*p == '-')) ? 1 : 0;
+        for (; (p < end) && (*p == '0'); ++p)
+        {
+        }
+        for (; (p < end) && is_digit(*p); ++p, ++count)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        if ((p < end) && (*p == '.'))
+        {
+            ++p;
+            if (count == 0)
+            {
+                for (digits = p; (p < end) && (*p == '0'); ++p)
+                {
+                }
+                exponent = digits - p;
+            }
+            for (digits = p; (p < end) && is_digit(*p); ++p, ++count)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+            }
+            exponent -= p - digits;
+        }
+        if (count > 19)
+        {
+            return false;
+        }
+        if ((p < end) && ((*p | 0x20) == 'e'))
+        {
+            ++p;
+            if ((*p == '+') || (*p == '-'))
+            {
+                exp_negative = (*p == '-');
+                ++p;
+            }
+            for (; p < end; ++p)
+            {
+                exp_value = exp_value * 10 + (*p - '0');
+                exp_value = (exp_value > 100000) ? 100000 : exp_value;
+            }
+            exponent += exp_negative ? -exp_value : exp_value;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Convert float characters to the bits of a 4 or 8 bytes float
+     */
+    constexpr uint64_t float_value(const char *p, const char *end, int size,
+            size_t offset)
+    {
+        constexpr float32_t powers32[] = {
+            1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+        };
+        constexpr float64_t powers64[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        uint64_t mantissa = 0;
+        int64_t exponent = 0;
+        uint64_t sign = 0;
+        uint64_t bits = 0;
+        bool exact = split_float(p, end, mantissa, exponent);
+
+        if (*p == '-')
+        {
+            sign = (size == 4) ? (1ULL << 31) : (1ULL << 63);
+        }
+        if (exact && (mantissa == 0))
+        {
+            return sign;
+        }
+        if (size == 4)
+        {
+            if (!exact || (mantissa > (1ULL << 24)) || (exponent < -10) || (exponent > 10))
+            {
+                inexact_float(offset);
+            }
+            float32_t value = (float32_t)mantissa;
+            value = (exponent < 0) ? value / powers32[-exponent] : value * powers32[exponent];
+            bits = float_bits(value, 23, 127);
+        }
+        else
+        {
+            if (!exact || (mantissa > (1ULL << 53)) || (exponent < -22) || (exponent > 22))
+            {
+                inexact_float(offset);
+            }
+            float64_t value = (float64_t)mantissa;
+            value = (exponent < 0) ? value / powers64[-exponent] : value * powers64[exponent];
+            bits = float_bits(value, 52, 1023);
+        }
+        return sign | bits;
+    }
+
+    /**
+     * Output of a conversion: the bytes are only counted without a buffer
+     */
+    class writer_t
+    {
+    private:
+        uint8_t *m_out;
+        size_t m_size;
+
+    public:
+        constexpr writer_t(uint8_t *out)
+                : m_out(out), m_size(0)
+        {
+        }
+
+        constexpr void put(uint8_t byte)
+        {
+            if (m_out != nullptr)
+            {
+                m_out[m_size] = byte;
+            }
+            ++m_size;
+        }
+
+        constexpr void put_number(uint64_t value, int size, endianess_t endianess)
+        {
+            for (int i = 0; i < size; ++i)
+            {
+                put((uint8_t)(value >> (8 * ((endianess == big_endian) ? size - 1 - i : i))));
+            }
+        }
+
+        /**
+         * @brief Repeat the bytes written since `start` to have them `count`
+         * times in total (none if `count` is 0)
+         */
+        constexpr void repeat(size_t start, uint64_t count)
+        {
+            size_t length = m_size - start;
+
+            if (count == 0)
+            {
+                m_size = start;
+                return;
+            }
+            for (uint64_t n = 1; n < count; ++n)
+            {
+                for (size_t i = 0; i < length; ++i)
+                {
+                    put((m_out != nullptr) ? m_out[start + i] : 0);
+                }
+            }
+        }
+
+        constexpr size_t size(void) const
+        {
+            return m_size;
+        }
+    };
+
+    /**
+     * @brief Convert a number element, as extract_number() does
+     */
+    constexpr void number(const char *p, size_t len, size_t offset, type_t type,
+            const modes_t & modes, writer_t & out)
+    {
+        const char *end = p + len;
+        const char *digits = p;
+        const char *q = p;
+        char prefix = "xdfob"[(type == t_num_hexadecimal) ? 0 : (type == t_num_decimal) ? 1 :
+                (type == t_num_float) ? 2 : (type == t_num_octal) ? 3 : 4];
+        int base = (type == t_num_hexadecimal) ? 16 : (type == t_num_octal) ? 8 :
+                (type == t_num_binary) ? 2 : 10;
+        bool negative = false;
+        int size = modes.size;
+        uint64_t value = 0;
+
+        if ((len >= 2) && (p[0] == '%') && (p[1] == prefix))
+        {
+            digits = q = p + 2;
+        }
+        if (((type == t_num_decimal) || (type == t_num_float)) && (q < end) &&
+                ((*q == '+') || (*q == '-')))
+        {
+            negative = (*q == '-');
+            ++q;
+        }
+        p = q;
+        for (; (q < end) && is_base_digit(*q, base); ++q)
+        {
+        }
+        if (q == p)
+        {
+            malformed_element(offset);
+        }
+        if (type == t_num_float)
+        {
+            if ((q < end) && (*q == '.'))
+            {
+                for (++q; (q < end) && is_digit(*q); ++q)
+                {
+                }
+            }
+            if ((q < end) && ((*q | 0x20) == 'e'))
+            {
+                ++q;
+                q += ((q < end) && ((*q == '+') || (*q == '-'))) ? 1 : 0;
+                p = q;
+                for (; (q < end) && is_digit(*q); ++q)
+                {
+                }
+                if (q == p)
+                {
+                    malformed_element(offset);
+                }
+            }
+        }
+        if ((q != end) && !bracket_value(q, end, size))
+        {
+            malformed_element(offset);
+        }
+
+        if (type == t_num_float)
+        {
+            size = ((size == 4) || (size == 8)) ? size : 4;
+            out.put_number(float_value(digits, q, size, offset), size, modes.endianess);
+            return;
+        }
+        for (p = digits + ((negative || (*digits == '+')) ? 1 : 0); p < q; ++p)
+        {
+            if (value > (UINT64_MAX - digit_value(*p)) / base)
+            {
+                number_out_of_range(offset);
+            }
+            value = value * base + digit_value(*p);
+        }
+        if (negative && (value > (uint64_t)INT64_MAX + 1))
+        {
+            number_out_of_range(offset);
+        }
+        if (size == 0)
+        {
+            if ((type == t_num_hexadecimal) || (type == t_num_binary))
+            {
+                // from the number of digits
+                size = size_of_bits((int)(q - digits) * ((type == t_num_hexadecimal) ? 4 : 1));
+            }
+            else if (negative)
+            {
+                // one more bit for the sign
+                size = size_of_bits(1 + bit_length((value > 0) ? value - 1 : 0));
+            }
+            else
+            {
+                size = size_of_bits(bit_length(value));
+            }
+        }
+        if (!is_valid_size(size) || (size == 0))
+        {
+            bad_size(offset);
+        }
+        out.put_number(negative ? 0 - value : value, size, modes.endianess);
+    }
+
+    /**
+     * @brief Convert a LEB128 number element "%u..." or "%s...", as
+     * extract_leb128() does
+     */
+    constexpr void leb128(const char *p, size_t len, size_t offset, bool is_signed,
+            writer_t & out)
+    {
+        const char *end = p + len;
+        const char *q = p + 2;
+        bool negative = false;
+        int size = 0;
+        int needed = 1;
+        uint64_t value = 0;
+
+        if (is_signed && (q < end) && ((*q == '+') || (*q == '-')))
+        {
+            negative = (*q == '-');
+            ++q;
+        }
+        p = q;
+        for (; (q < end) && is_digit(*q); ++q)
+        {
+            if (value > (UINT64_MAX - digit_value(*q)) / 10)
+            {
+                number_out_of_range(offset);
+            }
+            value = value * 10 + digit_value(*q);
+        }
+        if ((q == p) || ((q != end) && !bracket_value(q, end, size)))
+        {
+            malformed_element(offset);
+        }
+        if (is_signed && (value > (uint64_t)INT64_MAX + (negative ? 1 : 0)))
+        {
+            number_out_of_range(offset);
+        }
+        value = negative ? 0 - value : value;
+        // 7 bits groups, the last one holds the sign bit if signed
+        if (is_signed)
+        {
+            for (int64_t rest = (int64_t)value; (rest < -64) || (rest > 63); rest >>= 7)
+            {
+                ++needed;
+            }
+        }
+        else
+        {
+            for (uint64_t rest = value; rest > 0x7F; rest >>= 7)
+            {
+                ++needed;
+            }
+        }
+        if ((size != 0) && ((size > 10) || (size < needed)))
+        {
+            malformed_element(offset);
+        }
+        size = (size == 0) ? needed : size;
+        for (int i = 0; i < size; ++i)
+        {
+            uint64_t group = is_signed ? (uint64_t)((int64_t)value >> (7 * i)) : value >> (7 * i);
+            out.put((uint8_t)((group & 0x7F) | ((i + 1 < size) ? 0x80 : 0)));
+        }
+    }
+
+    /**
+     * @brief Recognize a keyword, a directive or a size state and update the
+     * modes. A fill directive writes its zero bytes, an alignment or a padding
+     * directive its padding bytes.
+     * @return false if the element is not an internal state
+     */
+    constexpr bool state(const char *p, size_t len, size_t offset, modes_t & modes,
+            writer_t & out)
+    {
+        const char *numbers[] = {
+            "hex", "hexa", "hexadecimal", "dec", "decimal", "float", "oct",
+            "octal", "bin", "binary"
+        };
+        const type_t types[] = {
+            t_num_hexadecimal, t_num_hexadecimal, t_num_hexadecimal,
+            t_num_decimal, t_num_decimal, t_num_float, t_num_octal,
+            t_num_octal, t_num_binary, t_num_binary
+        };
+        int size = 0;
+
+        for (size_t i = 0; i < sizeof(types) / sizeof(*types); ++i)
+        {
+            if (equals(p, len, numbers[i]))
+            {
+                modes.numbers = types[i];
+                return true;
+            }
+        }
+        if (equals(p, len, "big-endian") || equals(p, len, "little-endian"))
+        {
+            modes.endianess = (*p == 'b') ? big_endian : little_endian;
+            return true;
+        }
+        uint64_t count = 0;
+        if ((len >= 9) && equals(p, 7, "repeat[") && bracket_count(p + 6, p + len, count))
+        {
+            modes.repeat = count;
+            return true;
+        }
+        if ((len >= 7) && equals(p, 5, "fill[") && bracket_count(p + 4, p + len, count))
+        {
+            size_t start = out.size();
+
+            out.put(0);
+            out.repeat(start, count);
+            out.repeat(start, modes.repeat);
+            modes.repeat = 1;
+            return true;
+        }
+        uint8_t padding = 0;
+        bool align = (len >= 8) && equals(p, 6, "align[");
+        if ((align || ((len >= 9) && equals(p, 7, "pad-to["))) &&
+                bracket_padding(p + (align ? 5 : 6), p + len, count, padding))
+        {
+            if ((modes.repeat != 1) || (align && (count == 0)) ||
+                    (!align && (count < out.size())))
+            {
+                bad_padding(offset);
+            }
+            for (uint64_t n = align ? (count - out.size() % count) % count : count - out.size();
+                    n > 0; --n)
+            {
+                out.put(padding);
+            }
+            return true;
+        }
+        // "size[N]" anywhere in the element
+        for (size_t i = 0; (len >= 7) && (i + 7 <= len); ++i)
+        {
+            for (size_t end = i + 7; equals(p + i, 4, "size") && (end <= len); ++end)
+            {
+                if (bracket_value(p + i + 4, p + end, size))
+                {
+                    if (!is_valid_size(size))
+                    {
+                        bad_size(offset);
+                    }
+                    modes.size = size;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Convert an element, as BinStream::workflow() does
+     */
+    constexpr void element(const char *p, size_t len, size_t offset, modes_t & modes,
+            writer_t & out)
+    {
+        size_t start = out.size();
+        uint64_t count = modes.repeat;
+
+        if ((p[0] != '%') && (p[0] != '"') && (p[0] != '\'') &&
+                state(p, len, offset, modes, out))
+        {
+            return;
+        }
+        // a value consumes the pending repeat
+        modes.repeat = 1;
+        if ((p[0] == '%') && (len >= 3) && ((p[1] == 'u') || (p[1] == 's')))
+        {
+            leb128(p, len, offset, p[1] == 's', out);
+        }
+        else if (p[0] == '%')
+        {
+            if ((len < 3) || ((p[1] != 'x') && (p[1] != 'd') && (p[1] != 'f') &&
+                    (p[1] != 'o') && (p[1] != 'b')))
+            {
+                malformed_element(offset);
+            }
+            number(p, len, offset, (p[1] == 'x') ? t_num_hexadecimal :
+                    (p[1] == 'd') ? t_num_decimal : (p[1] == 'f') ? t_num_float :
+                    (p[1] == 'o') ? t_num_octal : t_num_binary, modes, out);
+        }
+        else if ((p[0] == '"') || (p[0] == '\''))
+        {
+            for (size_t i = 1; i + 1 < len; ++i)
+            {
+                out.put((uint8_t)p[i]);
+            }
+        }
+        else
+        {
+            number(p, len, offset, modes.numbers, modes, out);
+        }
+        out.repeat(start, count);
+    }
+
+    /**
+     * @brief Convert a description line after line, as BinStream does
+     *
+     * @param desc the description
+     * @param size the size of the description
+     * @param out the buffer receiving the bytes, or nullptr to only count them
+     * @return the number of bytes
+     */
+    constexpr size_t convert(const char *desc, size_t size, uint8_t *out)
+    {
+        modes_t modes = {little_endian, t_num_hexadecimal, 0, 1};
+        writer_t writer(out);
+        size_t line = 0;
+        size_t end = 0;
+        size_t word = 0;
+
+        while (line < size)
+        {
+            for (end = line; (end < size) && (desc[end] != '\n'); ++end)
+            {
+            }
+            size_t next = end + 1;
+            for (; (line < end) && is_space(desc[line]); ++line)
+            {
+            }
+            for (; (end > line) && is_space(desc[end - 1]); --end)
+            {
+            }
+            // empty and comment lines are ignored, a string line is whole
+            if ((line == end) || (desc[line] == '#'))
+            {
+            }
+            else if ((desc[line] == '"') || (desc[line] == '\''))
+            {
+                element(desc + line, end - line, line, modes, writer);
+            }
+            else
+            {
+                while (line < end)
+                {
+                    for (word = line; (line < end) && !is_space(desc[line]); ++line)
+                    {
+                    }
+                    element(desc + word, line - word, word, modes, writer);
+                    for (; (line < end) && is_space(desc[line]); ++line)
+                    {
+                    }
+                }
+            }
+            line = next;
+        }
+        if (modes.repeat != 1)
+        {
+            pending_repeat(size);
+        }
+        return writer.size();
+    }
+
+    /**
+     * @brief Get the number of bytes of a description
+     */
+    constexpr size_t measure(const char *desc, size_t size)
+    {
+        return convert(desc, size, nullptr);
+    }
+
+    template <size_t N>
+    struct buffer_t
+    {
+        uint8_t bytes[N + 1];
+    };
+
+    template <size_t N, size_t... I>
+    constexpr std::array<uint8_t, N> to_array(const buffer_t<N> & buffer,
+            std::index_sequence<I...>)
+    {
+        return {{buffer.bytes[I]...}};
+    }
+
+    /**
+     * @brief Convert a description to its bytes
+     *
+     * @param N the number of bytes (see measure())
+     * @param desc the description
+     * @param size the size of the description
+     * @return the bytes
+     */
+    template <size_t N>
+    constexpr std::array<uint8_t, N> encode(const char *desc, size_t size)
+    {
+        buffer_t<N> buffer = {};
+
+        convert(desc, size, buffer.bytes);
+        return to_array(buffer, std::make_index_sequence<N>());
+    }
+
+#if !(defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L))
+    template <typename Char, Char... Chars>
+    struct chars_t
+    {
+        static constexpr char value[] = {Chars..., '\0'};
+    };
+
+    template <typename Char, Char... Chars>
+    constexpr char chars_t<Char, Chars...>::value[];
+#else
+    template <size_t N>
+    struct chars_t
+    {
+        char value[N];
+
+        constexpr chars_t(const char (&s)[N])
+                : value{}
+        {
+            for (size_t i = 0; i < N; ++i)
+            {
+                value[i] = s[i];
+            }
+        }
+    };
+#endif
+}
+
+inline namespace literals
+{
+#if defined(__cpp_nontype_template_args) && (__cpp_nontype_template_args >= 201911L)
+    /**
+     * @brief Convert a description literal to its bytes at compile time
+     */
+    template <literal::chars_t Desc>
+    constexpr auto operator""_bin()
+    {
+        return literal::encode<literal::measure(Desc.value, sizeof(Desc.value) - 1)>(
+                Desc.value, sizeof(Desc.value) - 1);
+    }
+#elif defined(__GNUC__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+#ifdef __clang__
+#pragma GCC diagnostic ignored "-Wgnu-string-literal-operator-template"
+#endif
+    /**
+     * @brief Convert a description literal to its bytes at compile time
+     * (string literal operator template, a GNU extension before C++20)
+     */
+    template <typename Char, Char... Chars>
+    constexpr auto operator""_bin()
+    {
+        static_assert(std::is_same<Char, char>::value, "a description is a narrow string");
+        return literal::encode<literal::measure(literal::chars_t<Char, Chars...>::value,
+                sizeof...(Chars))>(literal::chars_t<Char, Chars...>::value, sizeof...(Chars));
+    }
+#pragma GCC diagnostic pop
+#endif
+}
+}
+
+#endif /* BS_LITERAL_H_ */
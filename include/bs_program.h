@@ -0,0 +1,86 @@
+/*
+ * bs_program.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef BS_PROGRAM_H_
+#define BS_PROGRAM_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "bs_data.h"
+#include "bs_sink.h"
+
+namespace BS
+{
+    class ProgramSink;
+
+    /**
+     * Compiled description: a compact sequence of literal byte runs and mode
+     * changes built by BinStream::compile(). Replaying it does not parse
+     * anything. A program is not modified once built, so one program can be
+     * run concurrently by several threads.
+     */
+    class Program
+    {
+    public:
+        typedef enum
+        {
+            op_bytes,     /** write the next `length` literal bytes */
+            op_endianess, /** set the endianess to `value` */
+            op_numbers,   /** set the default number type to `value` */
+            op_size,      /** set the default number size to `value` */
+            op_fill       /** write the next `length` literal bytes `count` times */
+        } opcode_t;
+
+        typedef struct
+        {
+            opcode_t code;
+            int value;
+            uint64_t length;
+            uint64_t count;
+        } op_t;
+
+    private:
+        std::vector<char> m_bytes; // the literal bytes of all the runs
+        std::vector<op_t> m_ops;
+        uint64_t m_size; // the size of the output
+
+        void add_bytes(const char *data, size_t size);
+        void add_fill(const char *pattern, size_t size, uint64_t count);
+        void add_mode(opcode_t code, int value);
+        void patch(uint64_t back, const char *data, size_t size);
+
+        friend class ProgramSink;
+
+    public:
+        Program(void);
+
+        void run(Sink & sink) const;
+        uint64_t size(void) const;
+        const std::vector<op_t>& ops(void) const;
+        const std::vector<char>& bytes(void) const;
+    };
+
+    /**
+     * Sink recording the generated data and the mode changes in a program
+     */
+    class ProgramSink: public Sink
+    {
+    private:
+        Program & m_program;
+
+    public:
+        ProgramSink(Program & program);
+
+        virtual void write(const char *data, size_t size);
+        virtual void fill(const char *pattern, size_t size, uint64_t count);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+        void set_mode(Program::opcode_t code, int value);
+    };
+}
+
+#endif /* BS_PROGRAM_H_ */
@@ -0,0 +1,204 @@
+/*
+ * bs_sink.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef BS_SINK_H_
+#define BS_SINK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+namespace BS
+{
+    /**
+     * Destination of the generated binary data.
+     * The data is written through write() as soon as it is generated.
+     * Bulk data can also be generated in place: prepare() returns room for
+     * at least `size` bytes and commit() appends the bytes actually written
+     * there. No other call must be made on the sink between both.
+     * A pattern repeated many times is written at once by fill().
+     * Bytes already written are overwritten by patch(), given how far back
+     * from the end of the written data they start. Sinks which cannot go
+     * back raise BSExceptionPatchFailed.
+     */
+    class Sink
+    {
+    private:
+        std::vector<char> m_scratch;
+
+    public:
+        static const size_t FILL_BLOCK_SIZE = 1024 * 1024;
+
+        virtual ~Sink(void) {}
+        virtual void write(const char *data, size_t size) = 0;
+        virtual void flush(void) {}
+        virtual char* prepare(size_t size);
+        virtual void commit(size_t size);
+        virtual void fill(const char *pattern, size_t size, uint64_t count);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+    };
+
+    /**
+     * Sink appending the data to a growable char vector
+     */
+    class VectorSink: public Sink
+    {
+    private:
+        std::vector<char> *m_buffer;
+        size_t m_prepared;
+
+    public:
+        VectorSink(std::vector<char> & buffer);
+
+        void bind(std::vector<char> & buffer);
+        std::vector<char>& buffer(void) const;
+        virtual void write(const char *data, size_t size);
+        virtual char* prepare(size_t size);
+        virtual void commit(size_t size);
+        virtual void fill(const char *pattern, size_t size, uint64_t count);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+    };
+
+    /**
+     * Sink writing the data to a caller-provided buffer of fixed capacity.
+     * Writing more than the capacity raises BSExceptionSinkFull.
+     */
+    class FixedBufferSink: public Sink
+    {
+    private:
+        char *m_buffer;
+        size_t m_capacity;
+        size_t m_size;
+
+    public:
+        FixedBufferSink(char *buffer, size_t capacity);
+
+        size_t size(void) const;
+        size_t capacity(void) const;
+        virtual void write(const char *data, size_t size);
+        virtual char* prepare(size_t size);
+        virtual void commit(size_t size);
+        virtual void fill(const char *pattern, size_t size, uint64_t count);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+    };
+
+    /**
+     * Sink writing the data to a POSIX file descriptor with large buffered
+     * writes. The file descriptor is not closed by the sink.
+     * A failing write raises BSExceptionWriteFailed.
+     */
+    class FdSink: public Sink
+    {
+    private:
+        int m_fd;
+        std::vector<char> m_buffer;
+        size_t m_used;
+
+        void write_all(const char *data, size_t size);
+
+    public:
+        static const size_t DEFAULT_BUFFER_SIZE = 1024 * 1024;
+
+        FdSink(int fd, size_t buffer_size=DEFAULT_BUFFER_SIZE);
+        virtual ~FdSink(void);
+
+        virtual void write(const char *data, size_t size);
+        virtual void flush(void);
+        virtual char* prepare(size_t size);
+        virtual void commit(size_t size);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+    };
+
+    /**
+     * Sink writing the data directly in a memory mapping of a regular file.
+     * The file is grown by ftruncate() as needed and truncated to the size of
+     * the written data when the sink is closed. The file descriptor is not
+     * closed by the sink.
+     * A failing mapping raises BSExceptionWriteFailed.
+     */
+    class MappedFileSink: public Sink
+    {
+    private:
+        int m_fd;
+        char *m_data;
+        size_t m_capacity;
+        size_t m_size;
+
+        void remap(size_t capacity);
+
+        MappedFileSink(const MappedFileSink &);
+        MappedFileSink& operator=(const MappedFileSink &);
+
+    public:
+        static const size_t DEFAULT_CAPACITY = 1024 * 1024;
+
+        MappedFileSink(int fd, size_t capacity=DEFAULT_CAPACITY);
+        virtual ~MappedFileSink(void);
+
+        size_t size(void) const;
+        virtual void write(const char *data, size_t size);
+        virtual char* prepare(size_t size);
+        virtual void commit(size_t size);
+        virtual void fill(const char *pattern, size_t size, uint64_t count);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+        void close(void);
+    };
+
+    /**
+     * Sink handing the data to a user callback
+     */
+    class CallbackSink: public Sink
+    {
+    public:
+        typedef std::function<void(const char *data, size_t size)> callback_t;
+
+    private:
+        callback_t m_callback;
+
+    public:
+        CallbackSink(callback_t callback);
+
+        virtual void write(const char *data, size_t size);
+    };
+
+    /**
+     * Sink only counting the size of the data, which is discarded
+     */
+    class CountingSink: public Sink
+    {
+    private:
+        uint64_t m_size;
+
+    public:
+        CountingSink(void);
+
+        uint64_t size(void) const;
+        virtual void write(const char *data, size_t size);
+        virtual void fill(const char *pattern, size_t size, uint64_t count);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+    };
+
+    /**
+     * Sink writing the data to an ostream
+     */
+    class StreamSink: public Sink
+    {
+    private:
+        std::ostream & m_stream;
+
+    public:
+        StreamSink(std::ostream & stream);
+
+        virtual void write(const char *data, size_t size);
+        virtual void flush(void);
+        virtual void patch(uint64_t back, const char *data, size_t size);
+    };
+}
+
+#endif /* BS_SINK_H_ */
@@ -0,0 +1,288 @@
+/*
+ * BinBuilder.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <cstring>
+
+#include "bin_tools.h"
+#include "BinBuilder.h"
+
+using namespace BS;
+
+/**
+ * @brief Create a builder writing to the output (or the sink) of a stream
+ *
+ * @param stream the BinStream receiving the values
+ */
+BS::BinBuilder::BinBuilder(BinStream & stream)
+        : m_stream(stream)
+{
+}
+
+/**
+ * @brief Write the `size` low-order bytes of a value
+ */
+BS::BinBuilder& BS::BinBuilder::number(uint64_t value, int size, bool num_signed,
+        endianess_t endianess)
+{
+    number_t number;
+
+    number.is_set = true;
+    number.endianess = endianess;
+    number.size = size;
+    number.num_signed = num_signed;
+    // floats are passed as their bits, which are stored as any integer
+    number.num_float = false;
+    number.value_u64 = value;
+    m_stream.emit_number(number);
+    return *this;
+}
+
+/**
+ * @brief Set the endianess of the stream, as the `big-endian` and
+ * `little-endian` keywords do
+ */
+BS::BinBuilder& BS::BinBuilder::endianess(endianess_t endianess)
+{
+    m_stream.set_endianess(endianess);
+    return *this;
+}
+
+BS::BinBuilder& BS::BinBuilder::big_endian(void)
+{
+    return endianess(BS::big_endian);
+}
+
+BS::BinBuilder& BS::BinBuilder::little_endian(void)
+{
+    return endianess(BS::little_endian);
+}
+
+BS::BinBuilder& BS::BinBuilder::u8(uint8_t value)
+{
+    return number(value, 1, false, BS::little_endian);
+}
+
+BS::BinBuilder& BS::BinBuilder::u16(uint16_t value)
+{
+    return u16(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::u32(uint32_t value)
+{
+    return u32(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::u64(uint64_t value)
+{
+    return u64(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::i8(int8_t value)
+{
+    return number((uint64_t)(int64_t)value, 1, true, BS::little_endian);
+}
+
+BS::BinBuilder& BS::BinBuilder::i16(int16_t value)
+{
+    return i16(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::i32(int32_t value)
+{
+    return i32(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::i64(int64_t value)
+{
+    return i64(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::f32(float32_t value)
+{
+    return f32(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::f64(float64_t value)
+{
+    return f64(value, m_stream.endianess());
+}
+
+BS::BinBuilder& BS::BinBuilder::u16(uint16_t value, endianess_t endianess)
+{
+    return number(value, 2, false, endianess);
+}
+
+BS::BinBuilder& BS::BinBuilder::u32(uint32_t value, endianess_t endianess)
+{
+    return number(value, 4, false, endianess);
+}
+
+BS::BinBuilder& BS::BinBuilder::u64(uint64_t value, endianess_t endianess)
+{
+    return number(value, 8, false, endianess);
+}
+
+BS::BinBuilder& BS::BinBuilder::i16(int16_t value, endianess_t endianess)
+{
+    return number((uint64_t)(int64_t)value, 2, true, endianess);
+}
+
+BS::BinBuilder& BS::BinBuilder::i32(int32_t value, endianess_t endianess)
+{
+    return number((uint64_t)(int64_t)value, 4, true, endianess);
+}
+
+BS::BinBuilder& BS::BinBuilder::i64(int64_t value, endianess_t endianess)
+{
+    return number((uint64_t)value, 8, true, endianess);
+}
+
+BS::BinBuilder& BS::BinBuilder::f32(float32_t value, endianess_t endianess)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return number(bits, 4, false, endianess);
+}
+
+BS::BinBuilder& BS::BinBuilder::f64(float64_t value, endianess_t endianess)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    return number(bits, 8, false, endianess);
+}
+
+/**
+ * @brief Write a number as an unsigned LEB128, as `%u` does
+ */
+BS::BinBuilder& BS::BinBuilder::uleb128(uint64_t value)
+{
+    char bytes[MAX_LEB128_SIZE];
+
+    m_stream.emit(bytes, encode_uleb128(value, bytes));
+    return *this;
+}
+
+/**
+ * @brief Write a number as a signed LEB128, as `%s` does
+ */
+BS::BinBuilder& BS::BinBuilder::sleb128(int64_t value)
+{
+    char bytes[MAX_LEB128_SIZE];
+
+    m_stream.emit(bytes, encode_sleb128(value, bytes));
+    return *this;
+}
+
+/**
+ * @brief Write many numbers as unsigned LEB128, encoded in batches
+ *
+ * @param values the numbers
+ * @param count the number of numbers
+ */
+BS::BinBuilder& BS::BinBuilder::uleb128(const uint64_t *values, size_t count)
+{
+    m_stream.emit_leb128s(values, count, false);
+    return *this;
+}
+
+/**
+ * @brief Write many numbers as signed LEB128, encoded in batches
+ *
+ * @param values the numbers
+ * @param count the number of numbers
+ */
+BS::BinBuilder& BS::BinBuilder::sleb128(const int64_t *values, size_t count)
+{
+    m_stream.emit_leb128s((const uint64_t *)values, count, true);
+    return *this;
+}
+
+/**
+ * @brief Write raw bytes
+ *
+ * @param data the bytes to write
+ * @param size the number of bytes
+ */
+BS::BinBuilder& BS::BinBuilder::bytes(const void *data, size_t size)
+{
+    if (size > 0)
+    {
+        m_stream.emit((const char *)data, size);
+    }
+    return *this;
+}
+
+BS::BinBuilder& BS::BinBuilder::bytes(const std::vector<char> & data)
+{
+    return bytes(data.data(), data.size());
+}
+
+/**
+ * @brief Write the characters of a string, without the terminating null
+ * character, as a quoted string of a description does
+ */
+BS::BinBuilder& BS::BinBuilder::str(const char *s)
+{
+    return bytes(s, strlen(s));
+}
+
+BS::BinBuilder& BS::BinBuilder::str(const std::string & s)
+{
+    return bytes(s.data(), s.size());
+}
+
+/**
+ * @brief Write a byte `count` times, as `fill[N]` does for zero bytes
+ *
+ * @param count the number of bytes
+ * @param value the byte to write
+ */
+BS::BinBuilder& BS::BinBuilder::fill(uint64_t count, uint8_t value)
+{
+    return repeat(&value, 1, count);
+}
+
+/**
+ * @brief Write raw bytes `count` times, as `repeat[N]` does for a value
+ *
+ * @param data the bytes to repeat
+ * @param size the number of bytes
+ * @param count the number of repetitions
+ */
+BS::BinBuilder& BS::BinBuilder::repeat(const void *data, size_t size, uint64_t count)
+{
+    m_stream.emit_fill((const char *)data, size, count);
+    return *this;
+}
+
+/**
+ * @brief Write a byte up to the next offset multiple of `alignment`, as
+ * `align[N]` does
+ *
+ * @param alignment the alignment in bytes (not 0)
+ * @param value the byte to write
+ */
+BS::BinBuilder& BS::BinBuilder::align(uint64_t alignment, uint8_t value)
+{
+    m_stream.emit_align(alignment, (char)value);
+    return *this;
+}
+
+/**
+ * @brief Write a byte up to the offset `offset` of the output, as
+ * `pad-to[N]` does
+ *
+ * @param offset the offset of the next written byte
+ * @param value the byte to write
+ */
+BS::BinBuilder& BS::BinBuilder::pad_to(uint64_t offset, uint8_t value)
+{
+    m_stream.emit_padding(offset, (char)value);
+    return *this;
+}
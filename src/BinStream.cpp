@@ -7,36 +7,196 @@
  */
 
 #include <iostream>
+#include <exception>
 #include <fstream>
 #include <sstream>
 #include <string>
-#include <math.h>
-#include <regex>
+#include <utility>
+#include <vector>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
 
 #include "utils.h"
 #include "bin_tools.h"
+#include "mapped_file.h"
+#include "work_pool.h"
 #include "BinStream.h"
 
 using namespace BS;
 
+namespace
+{
+    /**
+     * Modes set by a chunk of input. A mode which is not set keeps the value
+     * it had before the chunk.
+     */
+    struct chunk_modes_t
+    {
+        bool has_endianess;
+        endianess_t endianess;
+        bool has_numbers;
+        type_t numbers;
+        bool has_size;
+        int size;
+        bool has_repeat;
+        uint64_t repeat; // pending repeat count at the end of the chunk
+        bool has_offsets; // labels, references, checksums or alignments need
+                          // the offsets in the whole output
+    };
+
+    /**
+     * @brief Find the last value of each mode set by a chunk of input
+     * without converting anything, and whether it depends on the offsets in
+     * the output. The elements are split as proceed_line() and workflow() do.
+     *
+     * @param data the chunk of input
+     * @param size the size of the chunk
+     * @param modes will contain the modes set by the chunk
+     */
+    void scan_modes(const char *data, size_t size, chunk_modes_t & modes)
+    {
+        const char *end = data + size;
+        const char *line_end;
+        const char *word;
+        state_token_t tok;
+        type_t type;
+
+        modes.has_endianess = false;
+        modes.has_numbers = false;
+        modes.has_size = false;
+        modes.has_repeat = false;
+        modes.has_offsets = false;
+        while (data < end)
+        {
+            line_end = (const char *)memchr(data, '\n', end - data);
+            if (line_end == NULL)
+            {
+                line_end = end;
+            }
+            while ((data < line_end) && is_space(*data))
+            {
+                ++data;
+            }
+            // comments have no mode, a string line is a value
+            if ((data < line_end) && ((*data == '"') || (*data == '\'')))
+            {
+                modes.has_repeat = true;
+                modes.repeat = 1;
+            }
+            else if ((data < line_end) && (*data != '#'))
+            {
+                while (data < line_end)
+                {
+                    word = data;
+                    while ((data < line_end) && !is_space(*data))
+                    {
+                        ++data;
+                    }
+                    type = lex_type(word, data - word);
+                    if ((type == t_label) || (type == t_reference) || (type == t_checksum))
+                    {
+                        modes.has_offsets = true;
+                    }
+                    if (type == t_label)
+                    {
+                        // a label is not a value
+                    }
+                    else if ((type != t_internal_state) || !lex_state(word, data - word, tok))
+                    {
+                        // a value consumes the pending repeat
+                        modes.has_repeat = true;
+                        modes.repeat = 1;
+                    }
+                    else
+                    {
+                        switch(tok.type)
+                        {
+                        case t_state_type_endianess:
+                            modes.has_endianess = true;
+                            modes.endianess = tok.endianess;
+                            break;
+                        case t_state_type_number:
+                            modes.has_numbers = true;
+                            modes.numbers = tok.num_type;
+                            break;
+                        case t_state_type_size:
+                            modes.has_size = true;
+                            modes.size = tok.size;
+                            break;
+                        case t_state_type_repeat:
+                            modes.has_repeat = true;
+                            modes.repeat = tok.count;
+                            break;
+                        case t_state_type_align:
+                        case t_state_type_pad:
+                            modes.has_offsets = true;
+                            modes.has_repeat = true;
+                            modes.repeat = 1;
+                            break;
+                        case t_state_type_fill:
+                            modes.has_repeat = true;
+                            modes.repeat = 1;
+                            break;
+                        default:
+                            break;
+                        }
+                    }
+                    while ((data < line_end) && is_space(*data))
+                    {
+                        ++data;
+                    }
+                }
+            }
+            data = line_end + 1;
+        }
+    }
+}
+
 BS::BinStream::BinStream(bool verbose)
         : m_input(), m_output(),
+          m_output_sink(m_output),
+          m_sink(&m_output_sink),
+          m_recorder(NULL),
           m_curr_endianess(little_endian),
           m_curr_numbers(t_num_hexadecimal),
           m_curr_size(0),
+          m_repeat(1),
+          m_position(0),
+          m_labels(),
+          m_fixups(),
+          m_waiting(),
+          m_blocked(),
+          m_checksums(),
+          m_patches(),
           m_input_ready(false),
           m_output_ready(false),
-          m_verbose(verbose)
+          m_verbose(verbose),
+          m_keep_input(true),
+          m_errors(0)
 {
 }
 
 BS::BinStream::BinStream(const BS::BinStream& o)
-        : m_curr_endianess(o.m_curr_endianess),
+        : m_output_sink(m_output),
+          m_sink(o.m_sink == &o.m_output_sink ? &m_output_sink : o.m_sink),
+          m_recorder(NULL),
+          m_curr_endianess(o.m_curr_endianess),
           m_curr_numbers(o.m_curr_numbers),
           m_curr_size(0),
+          m_repeat(o.m_repeat),
+          m_position(o.m_position),
+          m_labels(o.m_labels),
+          m_fixups(o.m_fixups),
+          m_waiting(o.m_waiting),
+          m_blocked(o.m_blocked),
+          m_checksums(o.m_checksums),
+          m_patches(o.m_patches),
           m_input_ready(o.m_input_ready),
           m_output_ready(o.m_output_ready),
-          m_verbose(o.m_verbose)
+          m_verbose(o.m_verbose),
+          m_keep_input(o.m_keep_input),
+          m_errors(o.m_errors)
 {
     if (o.m_output_ready)
     {
@@ -48,18 +208,85 @@ BS::BinStream::BinStream(const BS::BinStream& o)
     }
 }
 
+/**
+ * @brief Move the input, the output and the modes of another instance.
+ * Nothing is copied. The other instance is left without input nor output.
+ */
+BS::BinStream::BinStream(BS::BinStream&& o)
+        : m_input(std::move(o.m_input)),
+          m_output(std::move(o.m_output)),
+          m_output_sink(m_output),
+          m_sink(o.m_sink == &o.m_output_sink ? &m_output_sink : o.m_sink),
+          m_recorder(NULL),
+          m_curr_endianess(o.m_curr_endianess),
+          m_curr_numbers(o.m_curr_numbers),
+          m_curr_size(o.m_curr_size),
+          m_repeat(o.m_repeat),
+          m_position(o.m_position),
+          m_labels(std::move(o.m_labels)),
+          m_fixups(std::move(o.m_fixups)),
+          m_waiting(std::move(o.m_waiting)),
+          m_blocked(std::move(o.m_blocked)),
+          m_checksums(o.m_checksums),
+          m_patches(std::move(o.m_patches)),
+          m_input_ready(o.m_input_ready),
+          m_output_ready(o.m_output_ready),
+          m_verbose(o.m_verbose),
+          m_keep_input(o.m_keep_input),
+          m_errors(o.m_errors)
+{
+    o.reset_output();
+    o.reset_input();
+}
+
 BS::BinStream::~BinStream()
 {
 }
 
 /**
- * @brief Reset the input, the output and the parsing modes.
+ * @brief Move the input, the output and the modes of another instance.
+ * Nothing is copied. The other instance is left without input nor output.
+ *
+ * @param o the instance to move
+ * @return the instance
+ */
+BS::BinStream& BS::BinStream::operator=(BS::BinStream&& o)
+{
+    if (this != &o)
+    {
+        m_input = std::move(o.m_input);
+        m_output = std::move(o.m_output);
+        m_sink = (o.m_sink == &o.m_output_sink) ? &m_output_sink : o.m_sink;
+        m_recorder = NULL;
+        copy_modes(o);
+        m_position = o.m_position;
+        m_labels = std::move(o.m_labels);
+        m_fixups = std::move(o.m_fixups);
+        m_waiting = std::move(o.m_waiting);
+        m_blocked = std::move(o.m_blocked);
+        m_checksums = o.m_checksums;
+        m_patches = std::move(o.m_patches);
+        m_input_ready = o.m_input_ready;
+        m_output_ready = o.m_output_ready;
+        m_verbose = o.m_verbose;
+        m_keep_input = o.m_keep_input;
+        m_errors = o.m_errors;
+        o.reset_output();
+        o.reset_input();
+    }
+    return *this;
+}
+
+/**
+ * @brief Reset the input, the output, the parsing modes and the number of
+ * errors.
  */
 void BS::BinStream::reset(void)
 {
     reset_modes();
     reset_output();
     reset_input();
+    m_errors = 0;
 }
 
 /**
@@ -70,15 +297,24 @@ void BS::BinStream::reset_modes(void)
 {
     m_curr_endianess = little_endian;
     m_curr_numbers = t_num_hexadecimal;
+    m_repeat = 1;
 }
 
 /**
- * @brief Reset the input data.
+ * @brief Reset the output data, with the labels, the references and the
+ * checksums.
  */
 void BS::BinStream::reset_output(void)
 {
     m_output_ready = false;
     m_output.clear();
+    m_position = 0;
+    m_labels.clear();
+    m_fixups.clear();
+    m_waiting.clear();
+    m_blocked.clear();
+    m_checksums = Checksums();
+    m_patches.clear();
 }
 
 /**
@@ -91,6 +327,19 @@ void BS::BinStream::reset_input(void)
     m_input.clear();
 }
 
+/**
+ * @brief Set the modes of parsing to the ones of another instance
+ *
+ * @param o the instance to copy the modes from
+ */
+void BS::BinStream::copy_modes(const BinStream & o)
+{
+    m_curr_endianess = o.m_curr_endianess;
+    m_curr_numbers = o.m_curr_numbers;
+    m_curr_size = o.m_curr_size;
+    m_repeat = o.m_repeat;
+}
+
 /**
  * @brief Check if an input is available.
  *
@@ -111,6 +360,18 @@ bool BS::BinStream::output_ready(void) const
     return m_output_ready;
 }
 
+/**
+ * @brief Get the number of elements in error (bad element, bad number or bad
+ * size). The elements in error do not generate output and the parsing goes
+ * on.
+ *
+ * @return the number of errors since the creation or the last reset
+ */
+size_t BS::BinStream::errors(void) const
+{
+    return m_errors;
+}
+
 /**
  * @brief Get the binary generated output.
  *
@@ -126,6 +387,40 @@ bool BS::BinStream::get_output(std::vector<char>& output) const
     return m_output_ready;
 }
 
+/**
+ * @brief Move the binary generated output out of the instance, which is left
+ * without output. Nothing is copied.
+ *
+ * @return the output binary data (empty if no output generated)
+ */
+std::vector<char> BS::BinStream::take_output(void)
+{
+    std::vector<char> output;
+
+    if (m_output_ready)
+    {
+        output.swap(m_output);
+    }
+    reset_output();
+    return output;
+}
+
+/**
+ * @brief Get a view of the binary generated output without copying it.
+ * The view is valid until the output is modified.
+ *
+ * @return the output binary data of size() bytes or NULL if no output
+ * generated
+ */
+const char* BS::BinStream::data(void) const
+{
+    if (m_output_ready)
+    {
+        return m_output.data();
+    }
+    return NULL;
+}
+
 size_t BS::BinStream::size(void) const
 {
     if (m_output_ready)
@@ -159,9 +454,8 @@ char BS::BinStream::operator[](const size_t index) const
  */
 BS::BinStream& BS::BinStream::operator<<(const std::istream & s)
 {
-    std::stringstream ss;
-    ss << s.rdbuf();
-    proceed_input(ss.str());
+    m_input_ready = true;
+    proceed_chunks(s.rdbuf(), DEFAULT_CHUNK_SIZE);
     return *this;
 }
 
@@ -174,12 +468,10 @@ BS::BinStream& BS::BinStream::operator<<(const std::istream & s)
  */
 BS::BinStream& BS::BinStream::operator<<(const std::ifstream & f)
 {
-    std::stringstream ss;
-
     if (f.is_open())
     {
-        ss << f.rdbuf();
-        proceed_input(ss.str());
+        m_input_ready = true;
+        proceed_chunks(f.rdbuf(), DEFAULT_CHUNK_SIZE);
     }
     return *this;
 }
@@ -206,7 +498,7 @@ BS::BinStream& BS::BinStream::operator<<(const std::stringstream & desc)
  */
 BS::BinStream& BS::BinStream::operator<<(const std::string & desc)
 {
-    proceed_input(desc);
+    proceed_input(desc.data(), desc.size());
     return *this;
 }
 
@@ -251,6 +543,207 @@ BS::BinStream& BS::BinStream::operator>>(std::ofstream & f)
     return *this;
 }
 
+/**
+ * @brief Compute the exact size of the output of a description without
+ * generating it. The instance is left unchanged, the description is proceeded
+ * from the current modes.
+ *
+ * @param data the description to measure
+ * @param size the size of the description
+ * @return the size in bytes of the output of the description
+ */
+uint64_t BS::BinStream::measure(const char *data, size_t size)
+{
+    BinStream measurer(m_verbose);
+    CountingSink counter;
+
+    measurer.copy_modes(*this);
+    measurer.m_keep_input = false;
+    measurer.set_sink(&counter);
+    measurer.proceed_input(data, size);
+    return counter.size();
+}
+
+/**
+ * @brief Compute the exact size of the output of a description without
+ * generating it. See measure(const char *, size_t).
+ *
+ * @param desc the description to measure
+ * @return the size in bytes of the output of the description
+ */
+uint64_t BS::BinStream::measure(const std::string & desc)
+{
+    return measure(desc.data(), desc.size());
+}
+
+/**
+ * @brief Compute the exact size of the output of a description read from a
+ * stream without generating it. See measure(const char *, size_t).
+ *
+ * @param in the istream input
+ * @return the size in bytes of the output of the description
+ */
+uint64_t BS::BinStream::measure(std::istream & in)
+{
+    BinStream measurer(m_verbose);
+    CountingSink counter;
+
+    measurer.copy_modes(*this);
+    measurer.m_keep_input = false;
+    measurer.set_sink(&counter);
+    measurer.proceed_chunks(in.rdbuf(), DEFAULT_CHUNK_SIZE);
+    return counter.size();
+}
+
+/**
+ * @brief Compile a description to a program. Running the program gives the
+ * same output and modes as proceeding the description from the current modes.
+ * The instance is left unchanged.
+ *
+ * @param data the description to compile
+ * @param size the size of the description
+ * @return the compiled program
+ */
+BS::Program BS::BinStream::compile(const char *data, size_t size) const
+{
+    BinStream compiler(m_verbose);
+    Program program;
+    ProgramSink recorder(program);
+
+    compiler.copy_modes(*this);
+    compiler.m_keep_input = false;
+    compiler.m_recorder = &recorder;
+    compiler.set_sink(&recorder);
+    compiler.proceed_input(data, size);
+    return program;
+}
+
+/**
+ * @brief Compile a description to a program.
+ * See compile(const char *, size_t).
+ *
+ * @param desc the description to compile
+ * @return the compiled program
+ */
+BS::Program BS::BinStream::compile(const std::string & desc) const
+{
+    return compile(desc.data(), desc.size());
+}
+
+/**
+ * @brief Compile a description read from a stream to a program.
+ * See compile(const char *, size_t).
+ *
+ * @param in the istream input
+ * @return the compiled program
+ */
+BS::Program BS::BinStream::compile(std::istream & in) const
+{
+    BinStream compiler(m_verbose);
+    Program program;
+    ProgramSink recorder(program);
+
+    compiler.copy_modes(*this);
+    compiler.m_keep_input = false;
+    compiler.m_recorder = &recorder;
+    compiler.set_sink(&recorder);
+    compiler.proceed_chunks(in.rdbuf(), DEFAULT_CHUNK_SIZE);
+    return program;
+}
+
+/**
+ * @brief Run a compiled program: write its bytes to the current sink and
+ * apply its mode changes.
+ *
+ * @param program the program to run
+ * @return the instance
+ */
+BS::BinStream& BS::BinStream::run(const Program & program)
+{
+    const char *p = program.bytes().data();
+
+    for (const Program::op_t & op : program.ops())
+    {
+        switch(op.code)
+        {
+        case Program::op_bytes:
+            emit(p, op.length);
+            p += op.length;
+            break;
+        case Program::op_fill:
+            emit_fill(p, op.length, op.count);
+            p += op.length;
+            break;
+        case Program::op_endianess:
+            m_curr_endianess = (endianess_t)op.value;
+            break;
+        case Program::op_numbers:
+            m_curr_numbers = (type_t)op.value;
+            break;
+        case Program::op_size:
+            m_curr_size = op.value;
+            break;
+        }
+        if ((m_recorder != NULL) && (op.code != Program::op_bytes) &&
+                (op.code != Program::op_fill))
+        {
+            m_recorder->set_mode(op.code, op.value);
+        }
+    }
+    return *this;
+}
+
+/**
+ * @brief Convert an input stream to a sink with bounded memory.
+ * The input is read by chunks of `chunk_size` bytes, a line split across two
+ * chunks is carried to the next one, and the generated data is written to
+ * the sink as soon as produced. The input is not kept and the output is not
+ * available afterwards with get_output() or operator[].
+ *
+ * @param in the istream input
+ * @param out the sink receiving the generated binary data
+ * @param chunk_size the size of the chunks read from the input
+ * @return true if the output was written else false
+ */
+bool BS::BinStream::stream(std::istream & in, Sink & out, size_t chunk_size)
+{
+    Sink *previous_sink = m_sink;
+    bool keep_input = m_keep_input;
+
+    m_sink = &out;
+    m_keep_input = false;
+    try
+    {
+        proceed_chunks(in.rdbuf(), chunk_size);
+    }
+    catch (...)
+    {
+        m_sink = previous_sink;
+        m_keep_input = keep_input;
+        throw;
+    }
+    m_sink = previous_sink;
+    m_keep_input = keep_input;
+    out.flush();
+    return true;
+}
+
+/**
+ * @brief Convert an input stream to an output stream with bounded memory.
+ * See stream(std::istream &, Sink &, size_t).
+ *
+ * @param in the istream input
+ * @param out the ostream receiving the generated binary data
+ * @param chunk_size the size of the chunks read from the input
+ * @return true if the output was written else false
+ */
+bool BS::BinStream::stream(std::istream & in, std::ostream & out, size_t chunk_size)
+{
+    StreamSink sink(out);
+    stream(in, sink, chunk_size);
+    return !out.fail();
+}
+
 namespace BS {
 /**
  * @brief Stream the output to a friend ostream
@@ -261,9 +754,9 @@ namespace BS {
  */
 std::ostream& operator<<(std::ostream& stream, const BinStream& bin_stream)
 {
-    for (size_t i = 0; i < bin_stream.size(); ++i)
+    if (bin_stream.size() > 0)
     {
-        stream << bin_stream[i];
+        stream.write(bin_stream.data(), bin_stream.size());
     }
     return stream;
 }
@@ -295,146 +788,1160 @@ std::istream& operator>>(std::istream& stream, BinStream& bin_stream)
  */
 void BS::BinStream::proceed_input(const std::string & element)
 {
-    std::stringstream sselem(element);
-    std::string line;
+    proceed_input(element.data(), element.size());
+}
 
-    m_input << element;
-    m_input_ready = true;
+/**
+ * @brief Proceed an input from a contiguous buffer and update the output.
+ * The input is tokenized in place. It is copied only if kept (see
+ * set_keep_input()).
+ *
+ * @param data the input data to proceed
+ * @param size the size of the input data
+ */
+void BS::BinStream::proceed_input(const char *data, size_t size)
+{
+    const char *end = data + size;
+    const char *nl;
 
-    while(getline(sselem, line))
+    if (m_keep_input)
     {
-        strip(line);
+        m_input.write(data, size);
+    }
+    m_input_ready = true;
 
-        // comment so ignore the line
-        if (starts_with(line, "#") || line.size() == 0)
-        {
-            bs_log("<ignore comment line>");
-        }
-        // line is a string
-        else if(starts_with(line, "\"") || starts_with(line, "\'"))
-        {
-            workflow(line);
-        }
-        // other: parse the line word after word
-        else
+    while (data < end)
+    {
+        nl = (const char *)memchr(data, '\n', end - data);
+        if (nl == NULL)
         {
-            std::stringstream ss(line);
-            std::string word;
-            while(ss >> word)
-            {
-                workflow(word);
-            }
+            nl = end;
         }
+        proceed_line(data, nl - data);
+        data = nl + 1;
     }
 }
 
 /**
- * @brief Proceed an element and update the output if success
+ * @brief Proceed a large input on several threads and update the output.
+ * The input is split in chunks at line boundaries. The chunks are first
+ * scanned for the mode keywords to know the modes at the start of each
+ * chunk, then they are converted at once and their outputs are written in
+ * order. The output, the modes and the errors are the same as the ones of
+ * proceed_input(). A small input is proceeded on the calling thread.
  *
- * @param element the element to proceed
+ * @param data the input data to proceed
+ * @param size the size of the input data
+ * @param threads the number of threads (one per processor if 0)
+ * @param chunk_size the minimal size of a chunk
  */
-void BS::BinStream::workflow(const std::string & element)
+void BS::BinStream::proceed_parallel(const char *data, size_t size, size_t threads,
+        size_t chunk_size)
 {
-    type_t elem_type;
-    number_t number;
+    WorkPool pool(threads);
+    std::vector<const char *> bounds(1, data);
+    std::vector<chunk_modes_t> modes;
+    std::vector<BinStream> parsers;
+    std::vector<std::exception_ptr> failures;
+    const char *end = data + size;
     const char *p;
-    std::string s(element);
+    size_t count;
+    size_t total = 0;
 
-    number.is_set = false;
-    elem_type = get_type(element);
-    switch(elem_type)
+    count = std::min(4 * pool.threads(), size / std::max(chunk_size, (size_t)1));
+    if ((pool.threads() < 2) || (count < 2) || (m_recorder != NULL))
     {
-    case t_error:
-        //TODO
-        bs_error("Error in workflow: bad element type");
-        break;
-    // internal state
-    case t_internal_state:
-        update_internal_state(element);
-        break;
-    // string
-    case t_string:
-        if (starts_with(s, "\"") || starts_with(s, "\'"))
+        proceed_input(data, size);
+        return;
+    }
+
+    // split at line boundaries
+    for (size_t i = 1; i < count; ++i)
+    {
+        p = data + i * (size / count);
+        if (p > bounds.back())
         {
-            bs_log("<string to bin>");
-            // remove delimiters
-            s = s.substr(1, s.size() - 2);
-            p = s.c_str();
-            // update the binary output
-            m_output.insert(m_output.end(), p, p + s.size());
-            m_output_ready = true;
+            p = (const char *)memchr(p, '\n', end - p);
+            if (p == NULL)
+            {
+                break;
+            }
+            bounds.push_back(p + 1);
         }
-        else
+    }
+    bounds.push_back(end);
+    count = bounds.size() - 1;
+
+    // get the modes at the start of each chunk
+    modes.resize(count);
+    pool.run(count, [&](size_t i) {
+        scan_modes(bounds[i], bounds[i + 1] - bounds[i], modes[i]);
+    });
+    // labels and alignments need the offsets in the whole output
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (modes[i].has_offsets)
         {
-            bs_error("Type string but not starting with string's delimiter !");
+            proceed_input(data, size);
+            return;
         }
-        break;
-    // not explicit number
-    case t_none:
-        elem_type = m_curr_numbers;
-        /* no break */
-    // number
-    default:
-        if(extract_number(element, number, elem_type, m_curr_endianess, m_curr_size))
+    }
+    if (m_keep_input)
+    {
+        m_input.write(data, size);
+    }
+    m_input_ready = true;
+    parsers.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        parsers.emplace_back(m_verbose);
+        parsers[i].copy_modes(*this);
+        parsers[i].set_keep_input(false);
+        m_curr_endianess = modes[i].has_endianess ? modes[i].endianess : m_curr_endianess;
+        m_curr_numbers = modes[i].has_numbers ? modes[i].numbers : m_curr_numbers;
+        m_curr_size = modes[i].has_size ? modes[i].size : m_curr_size;
+        m_repeat = modes[i].has_repeat ? modes[i].repeat : m_repeat;
+    }
+
+    // convert the chunks, an exception stops the output at its chunk
+    failures.resize(count);
+    pool.run(count, [&](size_t i) {
+        try
         {
-            // update the binary output
-            if (number.is_set)
-            {
-                bs_log("<number to bin>");
-                add_number_to_vector_char(m_output, number);
-                m_output_ready = true;
-            }
+            parsers[i].proceed_input(bounds[i], bounds[i + 1] - bounds[i]);
         }
-        break;
+        catch (...)
+        {
+            failures[i] = std::current_exception();
+        }
+    });
+    for (size_t i = 0; i < count; ++i)
+    {
+        total += parsers[i].m_output.size();
+    }
+    if (m_sink == &m_output_sink)
+    {
+        m_output.reserve(m_output.size() + total);
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (parsers[i].m_output_ready)
+        {
+            emit(parsers[i].m_output.data(), parsers[i].m_output.size());
+        }
+        m_errors += parsers[i].m_errors;
+        if (failures[i])
+        {
+            copy_modes(parsers[i]);
+            std::rethrow_exception(failures[i]);
+        }
+        // the chunk output is not needed anymore
+        std::vector<char>().swap(parsers[i].m_output);
     }
 }
 
 /**
- * @brief Update internal state
- * @return true if success else false
+ * @brief Proceed a memory-mapped file and update the output.
+ *
+ * @param path the path of the file to proceed
+ * @return true if the file was mapped else false
  */
-bool BS::BinStream::update_internal_state(const std::string & element)
+bool BS::BinStream::proceed_file(const std::string & path)
 {
-    bool ret(true);
-    std::string s(element);
-    std::string stmp(element);
-    std::regex pattern;
-    std::smatch match;
-    state_type_t state_type(t_state_type_error);
+    MappedFile file;
+
+    if (!file.open(path))
+    {
+        return false;
+    }
+    proceed_input(file.data(), file.size());
+    return true;
+}
 
-    strip(s);
+/**
+ * @brief Proceed an input read by chunks from a stream buffer.
+ * A line split across two chunks is carried to the next one.
+ *
+ * @param buf the stream buffer to read
+ * @param chunk_size the size of the chunks
+ */
+void BS::BinStream::proceed_chunks(std::streambuf *buf, size_t chunk_size)
+{
+    std::vector<char> chunk(chunk_size > 0 ? chunk_size : DEFAULT_CHUNK_SIZE);
+    std::string pending;
+    std::streamsize n;
 
-    ret = get_state_type(s, state_type);
-    switch(state_type)
+    while ((buf != NULL) && ((n = buf->sgetn(chunk.data(), chunk.size())) > 0))
     {
-    // update endianess
-    case t_state_type_endianess:
-        extract_endianess(s, m_curr_endianess);
-        break;
+        proceed_chunk(chunk.data(), n, pending);
+    }
+    if (!pending.empty())
+    {
+        proceed_line(pending.data(), pending.size());
+    }
+}
 
-    // update number type
-    case t_state_type_number:
-        extract_number_type(s, m_curr_numbers);
-        break;
+/**
+ * @brief Proceed a chunk of an input read by chunks.
+ * The end of a line split across two chunks is carried in `pending` to the
+ * next chunk. Once the last chunk is proceeded, a pending line has to be
+ * proceeded with proceed_line().
+ *
+ * @param data the chunk to proceed
+ * @param size the size of the chunk
+ * @param pending the carried end of line (empty at the first chunk)
+ */
+void BS::BinStream::proceed_chunk(const char *data, size_t size, std::string & pending)
+{
+    const char *end = data + size;
+    const char *nl;
 
-    // update size
-    case t_state_type_size:
-        // extract the size
-        if (!extract_size(s, m_curr_size))
+    if (m_keep_input)
+    {
+        m_input.write(data, size);
+    }
+    while ((nl = (const char *)memchr(data, '\n', end - data)) != NULL)
+    {
+        if (pending.empty())
         {
-            ret = false;
-            bs_log("Failed to extract size from string '" + s + "'");
+            proceed_line(data, nl - data);
         }
-        break;
-
-    default:
-        bs_log("Unknown internal state '" + s + "'");
-        ret = false;
-        break;
+        else
+        {
+            pending.append(data, nl);
+            proceed_line(pending.data(), pending.size());
+            pending.clear();
+        }
+        data = nl + 1;
+    }
+    pending.append(data, end);
+}
+
+/**
+ * @brief Proceed a single line of input and update the output.
+ *
+ * @param line the line to proceed (leading and ending spaces are ignored)
+ * @param size the size of the line
+ */
+void BS::BinStream::proceed_line(const char *line, size_t size)
+{
+    const char *end = line + size;
+    const char *word;
+
+    while ((line < end) && is_space(*line))
+    {
+        ++line;
+    }
+    while ((end > line) && is_space(end[-1]))
+    {
+        --end;
+    }
+
+    // comment so ignore the line
+    if ((line == end) || (*line == '#'))
+    {
+        bs_log("<ignore comment line>");
+    }
+    // line is a string
+    else if ((*line == '"') || (*line == '\''))
+    {
+        workflow(line, end - line);
+    }
+    // other: proceed a line of hexadecimal bytes at once or parse the line
+    // word after word
+    else if (!proceed_hex_line(line, end - line))
+    {
+        while (line < end)
+        {
+            word = line;
+            while ((line < end) && !is_space(*line))
+            {
+                ++line;
+            }
+            workflow(word, line - word);
+            while ((line < end) && is_space(*line))
+            {
+                ++line;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Proceed at once a line made only of 2 digits hexadecimal numbers when
+ * they are bytes in the current modes. The result is the same as the one of
+ * the word after word parsing.
+ *
+ * @param line the line to proceed (without leading nor ending spaces)
+ * @param size the size of the line
+ * @return false if the line was not proceeded
+ */
+bool BS::BinStream::proceed_hex_line(const char *line, size_t size)
+{
+    char *out;
+    size_t count;
+
+    if ((m_curr_numbers != t_num_hexadecimal) ||
+            ((m_curr_size != 0) && (m_curr_size != 1)) || m_verbose || (m_repeat != 1))
+    {
+        return false;
+    }
+    // reject most other lines before preparing the output
+    if ((size < 2) || !isxdigit((unsigned char)line[0]) ||
+            !isxdigit((unsigned char)line[1]) || ((size > 2) && !is_space(line[2])))
+    {
+        return false;
+    }
+    // the room needed is an upper bound of the number of bytes
+    try
+    {
+        out = m_sink->prepare((size + 1) / 3);
+    }
+    catch (const BSExceptionSinkFull &)
+    {
+        return false;
+    }
+    if (!decode_hex_bytes(line, size, out, count))
+    {
+        m_sink->commit(0);
+        return false;
+    }
+    if (!m_labels.empty())
+    {
+        m_checksums.update(out, count);
+    }
+    m_sink->commit(count);
+    m_position += count;
+    if (m_sink == &m_output_sink)
+    {
+        m_output_ready = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Proceed an element and update the output if success
+ *
+ * @param element the element to proceed
+ */
+void BS::BinStream::workflow(const std::string & element)
+{
+    workflow(element.data(), element.size());
+}
+
+/**
+ * @brief Proceed an element and update the output if success
+ *
+ * @param element the element characters
+ * @param size the number of characters
+ */
+void BS::BinStream::workflow(const char *element, size_t size)
+{
+    type_t elem_type;
+    number_t number;
+    std::vector<char> bytes;
+    uint64_t count = 1;
+
+    number.is_set = false;
+    elem_type = lex_type(element, size);
+    // a value consumes the pending repeat, even if it is in error
+    if ((elem_type != t_internal_state) && (elem_type != t_label))
+    {
+        count = m_repeat;
+        m_repeat = 1;
+    }
+    switch(elem_type)
+    {
+    case t_error:
+        //TODO
+        bs_error("Error in workflow: bad element type");
+        break;
+    // internal state
+    case t_internal_state:
+        update_internal_state(element, size);
+        break;
+    // label definition
+    case t_label:
+        define_label(element + 1, size - 1);
+        break;
+    // offset of a label or distance between labels
+    case t_reference:
+        emit_reference(element, size, count);
+        break;
+    // checksum of the output between labels
+    case t_checksum:
+        emit_checksum(element, size, count);
+        break;
+    // LEB128 number
+    case t_num_uleb128:
+    case t_num_sleb128:
+        {
+            char leb[MAX_LEB128_SIZE];
+            size_t leb_size;
+
+            if (!extract_leb128(element, size, elem_type, leb, leb_size))
+            {
+                // the error is already reported by extract_leb128()
+                ++m_errors;
+            }
+            else if (count == 1)
+            {
+                emit(leb, leb_size);
+            }
+            else
+            {
+                emit_fill(leb, leb_size, count);
+            }
+        }
+        break;
+    // string
+    case t_string:
+        bs_log("<string to bin>");
+        // remove delimiters and update the binary output
+        if (count == 1)
+        {
+            emit(element + 1, (size >= 2) ? size - 2 : 0);
+        }
+        else
+        {
+            emit_fill(element + 1, (size >= 2) ? size - 2 : 0, count);
+        }
+        break;
+    // not explicit number
+    case t_none:
+        elem_type = m_curr_numbers;
+        /* no break */
+    // number
+    default:
+        if(extract_number(element, size, number, elem_type, m_curr_endianess, m_curr_size))
+        {
+            // update the binary output
+            if (number.is_set)
+            {
+                bs_log("<number to bin>");
+                if (count == 1)
+                {
+                    emit_number(number);
+                }
+                else
+                {
+                    add_number_to_vector_char(bytes, number);
+                    emit_fill(bytes.data(), bytes.size(), count);
+                }
+            }
+        }
+        else
+        {
+            // the error is already reported by extract_number()
+            ++m_errors;
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Update internal state
+ * @return true if success else false
+ */
+bool BS::BinStream::update_internal_state(const std::string & element)
+{
+    return update_internal_state(element.data(), element.size());
+}
+
+/**
+ * @brief Update internal state from the characters of an element
+ * @return true if success else false
+ */
+bool BS::BinStream::update_internal_state(const char *element, size_t size)
+{
+    bool ret(true);
+    state_token_t tok;
+
+    if (!lex_state(element, size, tok))
+    {
+        bs_log("Unknown internal state '" + std::string(element, size) + "'");
+        return false;
+    }
+    switch(tok.type)
+    {
+    // update endianess
+    case t_state_type_endianess:
+        set_endianess(tok.endianess);
+        break;
+
+    // update number type
+    case t_state_type_number:
+        m_curr_numbers = tok.num_type;
+        if (m_recorder != NULL)
+        {
+            m_recorder->set_mode(Program::op_numbers, m_curr_numbers);
+        }
+        break;
+
+    // repeat the next value
+    case t_state_type_repeat:
+        m_repeat = tok.count;
+        break;
+
+    // write zero bytes, as many times as a pending repeat asks
+    case t_state_type_fill:
+        {
+            const char zero = 0;
+
+            if ((m_repeat > 1) && (tok.count > SIZE_MAX / m_repeat))
+            {
+                bs_error("Cannot repeat " + std::to_string(m_repeat) + " times '" +
+                        std::string(element, size) + "', the size overflows");
+                ret = false;
+            }
+            else
+            {
+                emit_fill(&zero, 1, tok.count * m_repeat);
+            }
+            m_repeat = 1;
+        }
+        break;
+
+    // write the padding byte up to the next multiple of the alignment or up
+    // to an offset (a repeat would write nothing more)
+    case t_state_type_align:
+    case t_state_type_pad:
+        if (m_repeat != 1)
+        {
+            bs_error("Cannot repeat '" + std::string(element, size) + "'");
+            ret = false;
+        }
+        else if (tok.type == t_state_type_align)
+        {
+            ret = emit_align(tok.count, tok.padding);
+        }
+        else
+        {
+            ret = emit_padding(tok.count, tok.padding);
+        }
+        m_repeat = 1;
+        break;
+
+    // update size (a bad value is kept as the extraction did)
+    case t_state_type_size:
+        m_curr_size = tok.size;
+        if (m_recorder != NULL)
+        {
+            m_recorder->set_mode(Program::op_size, m_curr_size);
+        }
+        if (!is_valid_size(tok.size))
+        {
+            ret = false;
+            bs_error("Bad size " + std::to_string(tok.size) + " for default size. Should be 0, 1, 2, 4 or 8");
+            bs_log("Failed to extract size from string '" + std::string(element, size) + "'");
+        }
+        break;
+
+    default:
+        bs_log("Unknown internal state '" + std::string(element, size) + "'");
+        ret = false;
+        break;
     }
     return ret;
 }
 
+/**
+ * @brief Write data to the current sink
+ *
+ * @param data the data to write
+ * @param size the size of the data
+ */
+void BS::BinStream::emit(const char *data, size_t size)
+{
+    // the checksums are only needed from the first label
+    if (!m_labels.empty())
+    {
+        m_checksums.update(data, size);
+    }
+    m_sink->write(data, size);
+    m_position += size;
+    if (m_sink == &m_output_sink)
+    {
+        m_output_ready = true;
+    }
+}
+
+/**
+ * @brief Write a number to the current sink
+ *
+ * @param number the number to write
+ */
+void BS::BinStream::emit_number(const number_t & number)
+{
+    char bytes[8];
+    FixedBufferSink buffer(bytes, sizeof(bytes));
+
+    if (!m_labels.empty())
+    {
+        // the bytes are needed for the checksums
+        add_number_to_sink(buffer, number);
+        emit(bytes, buffer.size());
+        return;
+    }
+    add_number_to_sink(*m_sink, number);
+    m_position += number.size;
+    if (m_sink == &m_output_sink)
+    {
+        m_output_ready = true;
+    }
+}
+
+/**
+ * @brief Write a pattern repeated `count` times to the current sink, without
+ * expanding it first. A fill whose size or end offset overflows is reported
+ * and not written.
+ *
+ * @param pattern the bytes to repeat
+ * @param size the size of the pattern
+ * @param count the number of repetitions
+ */
+void BS::BinStream::emit_fill(const char *pattern, size_t size, uint64_t count)
+{
+    if ((size > 0) && (count > (SIZE_MAX - m_position) / size))
+    {
+        bs_error("Cannot write " + std::to_string(count) + " times " +
+                std::to_string(size) + " bytes, the size overflows");
+        return;
+    }
+    if (!m_labels.empty())
+    {
+        m_checksums.update(pattern, size, count);
+    }
+    m_sink->fill(pattern, size, count);
+    m_position += size * count;
+    if ((m_sink == &m_output_sink) && (size > 0) && (count > 0))
+    {
+        m_output_ready = true;
+    }
+}
+
+/**
+ * @brief Write many LEB128 numbers, encoded in place in the current sink
+ * when it provides room
+ *
+ * @param values the values (two's complement if signed)
+ * @param count the number of values
+ * @param is_signed signed LEB128 else unsigned
+ */
+void BS::BinStream::emit_leb128s(const uint64_t *values, size_t count, bool is_signed)
+{
+    const size_t batch = 512;
+    char local[batch * MAX_LEB128_SIZE];
+    char *out;
+    size_t n;
+    size_t size;
+
+    while (count > 0)
+    {
+        n = std::min(count, batch);
+        try
+        {
+            out = m_sink->prepare(n * MAX_LEB128_SIZE);
+        }
+        catch (const BSExceptionSinkFull &)
+        {
+            // the upper bound does not fit, the exact size may
+            size = encode_leb128s(values, n, is_signed, local);
+            emit(local, size);
+            values += n;
+            count -= n;
+            continue;
+        }
+        size = encode_leb128s(values, n, is_signed, out);
+        if (!m_labels.empty())
+        {
+            m_checksums.update(out, size);
+        }
+        m_sink->commit(size);
+        m_position += size;
+        if ((m_sink == &m_output_sink) && (size > 0))
+        {
+            m_output_ready = true;
+        }
+        values += n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief Write a padding byte up to the next offset multiple of an alignment,
+ * with a single fill
+ *
+ * @param alignment the alignment in bytes (not 0)
+ * @param padding the byte to write
+ * @return false if the alignment is 0
+ */
+bool BS::BinStream::emit_align(uint64_t alignment, char padding)
+{
+    if (alignment == 0)
+    {
+        bs_error("Bad alignment 0");
+        return false;
+    }
+    emit_fill(&padding, 1, (alignment - m_position % alignment) % alignment);
+    return true;
+}
+
+/**
+ * @brief Write a padding byte up to an offset of the output, with a single fill
+ *
+ * @param offset the offset of the next generated byte
+ * @param padding the byte to write
+ * @return false if the output is already past the offset
+ */
+bool BS::BinStream::emit_padding(uint64_t offset, char padding)
+{
+    if (offset < m_position)
+    {
+        bs_error("Cannot pad to offset " + std::to_string(offset) +
+                ", the output is already at offset " + std::to_string(m_position));
+        return false;
+    }
+    emit_fill(&padding, 1, offset - m_position);
+    return true;
+}
+
+/**
+ * @brief Write a reference to labels: the offset of a label ("@name") or the
+ * distance from a label to another one ("@name-base"), on the explicit size
+ * "[N]", else the default size, else 4 bytes. A reference to a label not
+ * defined yet is written as zeros and patched once the label is defined.
+ *
+ * @param element the reference characters
+ * @param size the number of characters
+ * @param count the number of times to write the reference (a reference not
+ * resolved yet cannot be repeated)
+ */
+void BS::BinStream::emit_reference(const char *element, size_t size, uint64_t count)
+{
+    reference_token_t tok;
+    fixup_t ref;
+
+    if (!lex_reference(element, size, tok))
+    {
+        bs_error("Bad reference '" + std::string(element, size) + "'");
+        return;
+    }
+    ref.position = m_position;
+    ref.label.assign(tok.label, tok.label_len);
+    ref.base.assign(tok.base, tok.base_len);
+    ref.size = (tok.has_size && (tok.size != 0)) ? tok.size : (m_curr_size != 0) ? m_curr_size : 4;
+    ref.endianess = m_curr_endianess;
+    ref.checksum = false;
+    ref.algorithm = t_checksum_crc32;
+    if ((ref.size == 0) || !is_valid_size(ref.size))
+    {
+        bs_error("Bad size " + std::to_string(ref.size) + " for reference '" +
+                std::string(element, size) + "'. Should be 1, 2, 4 or 8");
+        return;
+    }
+    emit_fixup(ref, element, size, count);
+}
+
+/**
+ * @brief Write a checksum of the output between two labels:
+ * "crc32[start:end]", "crc32c[start:end]" or "adler32[start:end]", on 4 bytes.
+ * A checksum which cannot be computed yet, because a label is not defined or
+ * because a placeholder between the labels is not patched, is written as
+ * zeros and patched once it can.
+ *
+ * @param element the checksum characters
+ * @param size the number of characters
+ * @param count the number of times to write the checksum (a checksum not
+ * computed yet cannot be repeated)
+ */
+void BS::BinStream::emit_checksum(const char *element, size_t size, uint64_t count)
+{
+    checksum_token_t tok;
+    fixup_t ref;
+
+    if (!lex_checksum(element, size, tok))
+    {
+        bs_error("Bad checksum '" + std::string(element, size) + "'");
+        return;
+    }
+    ref.position = m_position;
+    ref.label.assign(tok.start, tok.start_len);
+    ref.base.assign(tok.end, tok.end_len);
+    ref.size = 4;
+    ref.endianess = m_curr_endianess;
+    ref.checksum = true;
+    ref.algorithm = tok.type;
+    emit_fixup(ref, element, size, count);
+}
+
+/**
+ * @brief Write the value of a reference or of a checksum, or a placeholder
+ * if it cannot be computed yet
+ *
+ * @param ref the reference or the checksum at the current offset
+ * @param element the element characters
+ * @param size the number of characters
+ * @param count the number of times to write the value
+ */
+void BS::BinStream::emit_fixup(const fixup_t & ref, const char *element, size_t size,
+        uint64_t count)
+{
+    std::vector<char> bytes;
+    uint64_t value = 0;
+
+    if (!reference_value(ref, value))
+    {
+        // placeholder patched once the value is known
+        if (count > 1)
+        {
+            bs_error("Cannot repeat '" + std::string(element, size) +
+                    "' before its labels are defined");
+        }
+        else if (count == 1)
+        {
+            m_fixups.insert(std::make_pair(ref.position, ref));
+            wait_fixup(ref);
+        }
+        bytes.assign(ref.size, 0);
+    }
+    else
+    {
+        reference_bytes(ref, value, bytes);
+    }
+    if (count == 1)
+    {
+        emit(bytes.data(), bytes.size());
+    }
+    else
+    {
+        emit_fill(bytes.data(), bytes.size(), count);
+    }
+}
+
+/**
+ * @brief Define a label at the current offset of the output and patch the
+ * references and the checksums waiting for it
+ *
+ * @param name the label name
+ * @param size the size of the name
+ */
+void BS::BinStream::define_label(const char *name, size_t size)
+{
+    std::string label(name, size);
+    label_t def = {m_position, m_checksums};
+    std::unordered_map<std::string, std::vector<uint64_t> >::iterator waiting;
+    std::vector<uint64_t> offsets;
+
+    if (!m_labels.insert(std::make_pair(label, def)).second)
+    {
+        bs_error("Label '" + label + "' already defined");
+        return;
+    }
+    waiting = m_waiting.find(label);
+    if (waiting == m_waiting.end())
+    {
+        return;
+    }
+    offsets.swap(waiting->second);
+    m_waiting.erase(waiting);
+    resolve_fixups(offsets);
+}
+
+/**
+ * @brief Register a reference or a checksum not computed yet with the label
+ * it waits for, or a checksum with a placeholder between its labels
+ *
+ * @param ref the reference or the checksum, in the pending fixups
+ */
+void BS::BinStream::wait_fixup(const fixup_t & ref)
+{
+    std::unordered_map<std::string, label_t>::const_iterator label = m_labels.find(ref.label);
+    std::unordered_map<std::string, label_t>::const_iterator base;
+    uint64_t position;
+
+    if (label == m_labels.end())
+    {
+        m_waiting[ref.label].push_back(ref.position);
+        return;
+    }
+    if (ref.base.empty())
+    {
+        return;
+    }
+    base = m_labels.find(ref.base);
+    if (base == m_labels.end())
+    {
+        m_waiting[ref.base].push_back(ref.position);
+    }
+    else if (ref.checksum && pending_fixup(label->second.position, base->second.position,
+            ref.position, position))
+    {
+        m_blocked[position].push_back(ref.position);
+    }
+}
+
+/**
+ * @brief Patch the pending references and checksums which can be computed,
+ * register the others with what they wait for. The checksums waiting for a
+ * patched placeholder are tried next.
+ *
+ * @param offsets the offsets of the pending fixups to try, in the order they
+ * are tried
+ */
+void BS::BinStream::resolve_fixups(std::vector<uint64_t> & offsets)
+{
+    std::map<uint64_t, fixup_t>::iterator ref;
+    std::unordered_map<uint64_t, std::vector<uint64_t> >::iterator blocked;
+    std::vector<char> bytes;
+    uint64_t value;
+
+    for (size_t next = 0; next < offsets.size(); ++next)
+    {
+        ref = m_fixups.find(offsets[next]);
+        if (!reference_value(ref->second, value))
+        {
+            wait_fixup(ref->second);
+            continue;
+        }
+        bytes.clear();
+        reference_bytes(ref->second, value, bytes);
+        patch_output(ref->first, bytes);
+        blocked = m_blocked.find(ref->first);
+        if (blocked != m_blocked.end())
+        {
+            offsets.insert(offsets.end(), blocked->second.begin(), blocked->second.end());
+            m_blocked.erase(blocked);
+        }
+        m_fixups.erase(ref);
+    }
+}
+
+/**
+ * @brief Overwrite a placeholder of the output
+ *
+ * @param position the offset of the placeholder in the output
+ * @param bytes the new bytes
+ */
+void BS::BinStream::patch_output(uint64_t position, const std::vector<char> & bytes)
+{
+    patch_t patch;
+
+    m_sink->patch(m_position - position, bytes.data(), bytes.size());
+    // the checksums of the labels are taken before the patch
+    patch.position = position;
+    patch.size = bytes.size();
+    memcpy(patch.data, bytes.data(), bytes.size());
+    m_patches.insert(std::make_pair(position, patch));
+}
+
+/**
+ * @brief Find a pending reference or checksum whose placeholder overlaps a
+ * part of the output
+ *
+ * @param start the offset of the part
+ * @param end the offset after the part
+ * @param except the offset of a fixup to ignore
+ * @param position will contain the offset of the placeholder found
+ * @return true if a placeholder was found
+ */
+bool BS::BinStream::pending_fixup(uint64_t start, uint64_t end, uint64_t except,
+        uint64_t & position) const
+{
+    // a placeholder is at most 8 bytes long
+    std::map<uint64_t, fixup_t>::const_iterator f =
+            m_fixups.lower_bound((start >= 8) ? start - 7 : 0);
+
+    for (; (f != m_fixups.end()) && (f->first < end); ++f)
+    {
+        if ((f->first != except) && (f->first + f->second.size > start))
+        {
+            position = f->first;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Get the value of a reference or of a checksum
+ *
+ * @param ref the reference or the checksum
+ * @param value will contain the offset, the distance or the checksum
+ * @return false if a label is not defined yet, or if a placeholder between
+ * the labels of a checksum is not patched yet
+ */
+bool BS::BinStream::reference_value(const fixup_t & ref, uint64_t & value)
+{
+    std::unordered_map<std::string, label_t>::const_iterator label = m_labels.find(ref.label);
+    std::unordered_map<std::string, label_t>::const_iterator base = m_labels.find(ref.base);
+    uint64_t start, end, position;
+    Checksums sum;
+
+    if ((label == m_labels.end()) || (!ref.base.empty() && (base == m_labels.end())))
+    {
+        return false;
+    }
+    if (!ref.checksum)
+    {
+        value = label->second.position - (ref.base.empty() ? 0 : base->second.position);
+        return true;
+    }
+    start = label->second.position;
+    end = base->second.position;
+    value = 0;
+    if (end < start)
+    {
+        bs_error("Checksum from '" + ref.label + "' to '" + ref.base +
+                "': the end is before the start");
+        return true;
+    }
+    if (pending_fixup(start, end, ref.position, position))
+    {
+        return false;
+    }
+    // from the checksums of the output up to both labels, as first written
+    sum = base->second.checksums.suffix(label->second.checksums, end - start);
+    for (std::map<uint64_t, patch_t>::const_iterator patch = m_patches.lower_bound(start);
+            (patch != m_patches.end()) && (patch->first < end); ++patch)
+    {
+        sum.patch(patch->second.data, patch->second.size, end - patch->first - patch->second.size);
+    }
+    value = sum.value(ref.algorithm);
+    return true;
+}
+
+/**
+ * @brief Get the bytes of the value of a reference. A value which does not fit
+ * in the size of the reference is reported and written as zeros.
+ *
+ * @param ref the reference
+ * @param value the offset (unsigned) or the distance (signed or not)
+ * @param bytes will be appended the bytes
+ */
+void BS::BinStream::reference_bytes(const fixup_t & ref, uint64_t value,
+        std::vector<char> & bytes)
+{
+    number_t number;
+    int bits = 8 * ref.size;
+    bool fits = (bits == 64) || ((value >> bits) == 0) ||
+            (!ref.base.empty() && ((int64_t)value < 0) &&
+                    ((int64_t)value >= -((int64_t)1 << (bits - 1))));
+
+    if (!fits)
+    {
+        bs_error("Reference to '" + ref.label + "' does not fit in " +
+                std::to_string(ref.size) + " bytes");
+        value = 0;
+    }
+    number.is_set = true;
+    number.endianess = ref.endianess;
+    number.size = ref.size;
+    number.num_signed = false;
+    number.num_float = false;
+    number.value_u64 = value;
+    add_number_to_vector_char(bytes, number);
+}
+
+/**
+ * @brief Get the offset in the output of the next generated byte, that is the
+ * number of bytes generated since the output was reset
+ */
+uint64_t BS::BinStream::position(void) const
+{
+    return m_position;
+}
+
+/**
+ * @brief Get the number of references waiting for labels not defined yet
+ */
+size_t BS::BinStream::unresolved(void) const
+{
+    return m_fixups.size();
+}
+
+/**
+ * @brief Check that all the references were resolved and that no repeat is
+ * pending, once the whole description is proceeded
+ * @exception BSExceptionUnresolvedLabel a label is referenced but not defined
+ * @exception BSExceptionUnresolvedChecksum a checksum depends on itself
+ * @exception BSExceptionPendingRepeat a repeat is not followed by a value
+ */
+void BS::BinStream::check_references(void) const
+{
+    if (m_repeat != 1)
+    {
+        throw BSExceptionPendingRepeat(m_repeat);
+    }
+    if (!m_fixups.empty())
+    {
+        const fixup_t & ref = m_fixups.begin()->second;
+        if (m_labels.count(ref.label) == 0)
+        {
+            throw BSExceptionUnresolvedLabel(ref.label);
+        }
+        if (!ref.base.empty() && (m_labels.count(ref.base) == 0))
+        {
+            throw BSExceptionUnresolvedLabel(ref.base);
+        }
+        throw BSExceptionUnresolvedChecksum(ref.label, ref.base);
+    }
+}
+
+/**
+ * @brief Set the sink receiving the generated data.
+ * By default the data is stored in the instance and is available with
+ * get_output(), operator[] or the output stream operators.
+ * The sink is not owned by the instance.
+ *
+ * @param sink the sink to use or NULL to restore the default one
+ */
+void BS::BinStream::set_sink(Sink *sink)
+{
+    m_sink = (sink != NULL) ? sink : &m_output_sink;
+}
+
+/**
+ * @brief Get the sink receiving the generated data
+ */
+BS::Sink& BS::BinStream::sink(void) const
+{
+    return *m_sink;
+}
+
+/**
+ * @brief Set the endianess of the next numbers, as the `big-endian` and
+ * `little-endian` keywords do
+ *
+ * @param endianess the endianess to use
+ */
+void BS::BinStream::set_endianess(endianess_t endianess)
+{
+    m_curr_endianess = endianess;
+    if (m_recorder != NULL)
+    {
+        m_recorder->set_mode(Program::op_endianess, m_curr_endianess);
+    }
+}
+
+/**
+ * @brief Get the endianess of the next numbers
+ */
+BS::endianess_t BS::BinStream::endianess(void) const
+{
+    return m_curr_endianess;
+}
+
+/**
+ * @brief Set if the raw input text is kept in the instance.
+ * Not keeping it avoids a copy of the whole input. Default is to keep it.
+ *
+ * @param keep true to keep the input else false
+ */
+void BS::BinStream::set_keep_input(bool keep)
+{
+    m_keep_input = keep;
+}
 
 void BS::BinStream::set_verbosity(bool verbose)
 {
@@ -451,6 +1958,7 @@ void BS::BinStream::bs_log(std::string msg)
 
 void BS::BinStream::bs_error(std::string msg)
 {
+    ++m_errors;
     error_message(msg);
 }
 
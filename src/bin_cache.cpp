@@ -0,0 +1,312 @@
+/*
+ * bin_cache.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/fs.h>
+
+#include "bin_cache.h"
+
+using namespace BS;
+
+namespace
+{
+    inline uint64_t rotl64(uint64_t x, int r)
+    {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    inline uint64_t fmix64(uint64_t k)
+    {
+        k ^= k >> 33;
+        k *= 0xff51afd7ed558ccdULL;
+        k ^= k >> 33;
+        k *= 0xc4ceb9a64ef3e53ULL;
+        k ^= k >> 33;
+        return k;
+    }
+
+    inline uint64_t read64(const char *p)
+    {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; --i)
+        {
+            v = (v << 8) | (uint8_t)p[i];
+        }
+        return v;
+    }
+
+    /**
+     * @brief Write all the data to a file descriptor
+     * @return true if success else false
+     */
+    bool write_all(int fd, const char *data, size_t size)
+    {
+        ssize_t n;
+
+        while (size > 0)
+        {
+            n = write(fd, data, size);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                return false;
+            }
+            data += n;
+            size -= n;
+        }
+        return true;
+    }
+}
+
+/**
+ * @brief Compute a 128 bits hash of data (MurmurHash3 x64 128).
+ *
+ * @param data the data to hash
+ * @param size the size of the data
+ * @param seed the seed of the hash
+ * @param hash will contain the hash
+ */
+void BS::hash128(const char *data, size_t size, uint64_t seed, uint64_t hash[2])
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    const char *tail = data + (size & ~(size_t)15);
+    uint64_t h1 = seed;
+    uint64_t h2 = seed;
+    uint64_t k1;
+    uint64_t k2;
+
+    for (const char *p = data; p < tail; p += 16)
+    {
+        k1 = read64(p);
+        k2 = read64(p + 8);
+
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    k1 = 0;
+    k2 = 0;
+    for (size_t i = size & 15; i > 8; --i)
+    {
+        k2 = (k2 << 8) | (uint8_t)tail[i - 1];
+    }
+    for (size_t i = std::min(size & 15, (size_t)8); i > 0; --i)
+    {
+        k1 = (k1 << 8) | (uint8_t)tail[i - 1];
+    }
+    if ((size & 15) > 8)
+    {
+        k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+    }
+    if ((size & 15) > 0)
+    {
+        k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= size;
+    h2 ^= size;
+    h1 += h2;
+    h2 += h1;
+    h1 = fmix64(h1);
+    h2 = fmix64(h2);
+    h1 += h2;
+    h2 += h1;
+    hash[0] = h1;
+    hash[1] = h2;
+}
+
+/**
+ * @brief Copy a file to a file descriptor, at its current position.
+ * A reflink is used if the file systems support it and the descriptor is an
+ * empty regular file (a reflink replaces the whole file), else the data is
+ * copied by the kernel if possible.
+ *
+ * @param from the path of the file to copy
+ * @param to_fd the file descriptor to write to
+ * @return true if success else false
+ */
+bool BS::copy_file(const std::string & from, int to_fd)
+{
+    char buffer[64 * 1024];
+    struct stat st;
+    struct stat to_st;
+    ssize_t n;
+    off_t remaining;
+    bool ret(true);
+    int fd = open(from.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        return false;
+    }
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    if ((fstat(to_fd, &to_st) == 0) && S_ISREG(to_st.st_mode) && (to_st.st_size == 0) &&
+            (lseek(to_fd, 0, SEEK_CUR) == 0) && (ioctl(to_fd, FICLONE, fd) == 0))
+    {
+        close(fd);
+        return true;
+    }
+    remaining = st.st_size;
+    while (remaining > 0)
+    {
+        n = sendfile(to_fd, fd, NULL, remaining);
+        if (n <= 0)
+        {
+            break;
+        }
+        remaining -= n;
+    }
+    // sendfile not supported between these files
+    while (ret && (remaining > 0))
+    {
+        n = read(fd, buffer, sizeof(buffer));
+        if (n <= 0)
+        {
+            ret = false;
+            break;
+        }
+        ret = write_all(to_fd, buffer, n);
+        remaining -= n;
+    }
+    close(fd);
+    return ret;
+}
+
+////////////////////////////////    BinCache    ////////////////////////////////
+
+/**
+ * @brief Create a cache in a directory (see usable())
+ *
+ * @param dir the cache directory
+ * @param salt data hashed with each description (e.g. the version of the
+ * generator) so that entries of another salt are not used
+ */
+BS::BinCache::BinCache(const std::string & dir, const std::string & salt)
+        : m_dir(dir), m_salt(salt)
+{
+}
+
+/**
+ * @brief Create the cache directory if needed and check that entries can be
+ * added to it
+ *
+ * @return true if the cache can be used else false
+ */
+bool BS::BinCache::usable(void) const
+{
+    struct stat st;
+
+    mkdir(m_dir.c_str(), 0777);
+    return (stat(m_dir.c_str(), &st) == 0) && S_ISDIR(st.st_mode) &&
+            (access(m_dir.c_str(), W_OK | X_OK) == 0);
+}
+
+/**
+ * @brief Get the path of the cache entry of a description
+ *
+ * @param data the description
+ * @param size the size of the description
+ * @return the path of the entry (it may not exist)
+ */
+std::string BS::BinCache::entry(const char *data, size_t size) const
+{
+    uint64_t salt[2];
+    uint64_t hash[2];
+    char name[40];
+
+    hash128(m_salt.data(), m_salt.size(), 0, salt);
+    hash128(data, size, salt[0] ^ salt[1], hash);
+    snprintf(name, sizeof(name), "%016llx%016llx.bin",
+            (unsigned long long)hash[0], (unsigned long long)hash[1]);
+    return m_dir + "/" + name;
+}
+
+/**
+ * @brief Check if an entry exists in the cache
+ */
+bool BS::BinCache::contains(const std::string & entry) const
+{
+    return access(entry.c_str(), R_OK) == 0;
+}
+
+/**
+ * @brief Get a path private to this call to generate an entry before
+ * publishing it. Several threads of a process can generate the same entry.
+ */
+std::string BS::BinCache::temp_path(const std::string & entry) const
+{
+    static std::atomic<unsigned long> counter(0);
+
+    return entry + "." + std::to_string(getpid()) + "." +
+            std::to_string(counter++) + ".tmp";
+}
+
+/**
+ * @brief Atomically make a generated file an entry of the cache
+ *
+ * @param temp_path the generated file (see temp_path())
+ * @param entry the entry
+ * @return true if success else false
+ */
+bool BS::BinCache::publish(const std::string & temp_path, const std::string & entry) const
+{
+    if (rename(temp_path.c_str(), entry.c_str()) != 0)
+    {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Copy an entry of the cache, or a generated file not yet published,
+ * to an output file
+ *
+ * @param entry the entry or the generated file (see temp_path())
+ * @param output_file the output file name (stdout if empty)
+ * @return true if success else false
+ */
+bool BS::BinCache::fetch(const std::string & entry, const std::string & output_file) const
+{
+    bool ret;
+    int fd;
+
+    if (output_file.empty())
+    {
+        return copy_file(entry, STDOUT_FILENO);
+    }
+    fd = open(output_file.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd < 0)
+    {
+        return false;
+    }
+    ret = copy_file(entry, fd);
+    if (close(fd) != 0)
+    {
+        ret = false;
+    }
+    return ret;
+}
@@ -0,0 +1,43 @@
+/*
+ * bin_cache.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef BIN_CACHE_H_
+#define BIN_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace BS
+{
+    /**
+     * On-disk cache of generated binaries keyed by a hash of their
+     * description. An entry is a file named after the hash in the cache
+     * directory.
+     */
+    class BinCache
+    {
+    private:
+        std::string m_dir;
+        std::string m_salt;
+
+    public:
+        BinCache(const std::string & dir, const std::string & salt);
+
+        bool usable(void) const;
+        std::string entry(const char *data, size_t size) const;
+        bool contains(const std::string & entry) const;
+        std::string temp_path(const std::string & entry) const;
+        bool publish(const std::string & temp_path, const std::string & entry) const;
+        bool fetch(const std::string & entry, const std::string & output_file) const;
+    };
+
+    void hash128(const char *data, size_t size, uint64_t seed, uint64_t hash[2]);
+    bool copy_file(const std::string & from, int to_fd);
+}
+
+#endif /* BIN_CACHE_H_ */
@@ -1,10 +1,1183 @@
 #include <string>
-#include <regex>
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cmath>
+#include <cstring>
+#include <locale.h>
+#include <stdexcept>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "bs_data.h"
 #include "utils.h"
 #include "bin_tools.h"
 
+////////////////////////////////    LEXER    ///////////////////////////////////
+
+namespace
+{
+    inline bool is_digit(char c)
+    {
+        return (c >= '0') && (c <= '9');
+    }
+
+    inline bool is_hex_digit(char c)
+    {
+        return is_digit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'f');
+    }
+
+    inline bool is_oct_digit(char c)
+    {
+        return (c >= '0') && (c <= '7');
+    }
+
+    inline bool is_bin_digit(char c)
+    {
+        return (c == '0') || (c == '1');
+    }
+
+    inline bool is_zero(char c)
+    {
+        return c == '0';
+    }
+
+    inline bool is_label_char(char c)
+    {
+        return is_digit(c) || (((c | 0x20) >= 'a') && ((c | 0x20) <= 'z')) ||
+                (c == '_') || (c == '.');
+    }
+
+    /**
+     * @brief Recognize the name of a checksum algorithm followed by '['
+     * @return the position of the '[' or NULL if not a checksum
+     */
+    const char *checksum_name(const char *p, const char *end, BS::checksum_type_t & type)
+    {
+        static const struct
+        {
+            const char *name;
+            size_t len;
+            BS::checksum_type_t type;
+        } names[] = {
+            {"crc32[", 6, BS::t_checksum_crc32},
+            {"crc32c[", 7, BS::t_checksum_crc32c},
+            {"adler32[", 8, BS::t_checksum_adler32},
+        };
+
+        for (const auto & n : names)
+        {
+            if (((size_t)(end - p) >= n.len) && (memcmp(p, n.name, n.len) == 0))
+            {
+                type = n.type;
+                return p + n.len - 1;
+            }
+        }
+        return NULL;
+    }
+
+    /**
+     * @brief Get the value of a valid hexadecimal digit
+     */
+    inline unsigned hex_value(char c)
+    {
+        return is_digit(c) ? (unsigned)(c - '0') : (unsigned)((c | 0x20) - 'a' + 10);
+    }
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    const BS::endianess_t host_endianess = BS::big_endian;
+#else
+    const BS::endianess_t host_endianess = BS::little_endian;
+#endif
+
+    inline uint8_t byte_swap(uint8_t v)
+    {
+        return v;
+    }
+
+    inline uint16_t byte_swap(uint16_t v)
+    {
+        return __builtin_bswap16(v);
+    }
+
+    inline uint32_t byte_swap(uint32_t v)
+    {
+        return __builtin_bswap32(v);
+    }
+
+    inline uint64_t byte_swap(uint64_t v)
+    {
+        return __builtin_bswap64(v);
+    }
+
+    /**
+     * @brief Skip the characters accepted by a predicate
+     * @return the first not accepted position
+     */
+    template <typename Pred>
+    inline const char *skip(const char *p, const char *end, Pred pred)
+    {
+        while ((p < end) && pred(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    /**
+     * @brief Parse a bracketed decimal value "[N]" starting at p.
+     * A too big value is saturated to INT_MAX.
+     *
+     * @return the position after ']' or NULL if not a bracketed value
+     */
+    const char *lex_bracket_value(const char *p, const char *end, int & value)
+    {
+        const char *q;
+        long long v = 0;
+
+        if ((p >= end) || (*p != '['))
+        {
+            return NULL;
+        }
+        q = skip(p + 1, end, is_digit);
+        if ((q == p + 1) || (q >= end) || (*q != ']'))
+        {
+            return NULL;
+        }
+        for (const char *d = p + 1; d < q; ++d)
+        {
+            v = v * 10 + (*d - '0');
+            if (v > INT_MAX)
+            {
+                v = INT_MAX;
+            }
+        }
+        value = (int)v;
+        return q + 1;
+    }
+
+    /**
+     * @brief Parse a bracketed decimal count "[N]" starting at p, or the
+     * start "[N," of a longer bracket when a separator is given.
+     * A too big count is saturated to UINT64_MAX.
+     *
+     * @return the position after ']' (or the separator) or NULL if not a
+     * bracketed count
+     */
+    const char *lex_bracket_count(const char *p, const char *end, uint64_t & count,
+            char separator=']')
+    {
+        const char *q;
+        uint64_t v = 0;
+
+        if ((p >= end) || (*p != '['))
+        {
+            return NULL;
+        }
+        q = skip(p + 1, end, is_digit);
+        if ((q == p + 1) || (q >= end) || ((*q != ']') && (*q != separator)))
+        {
+            return NULL;
+        }
+        for (const char *d = p + 1; d < q; ++d)
+        {
+            v = (v > (UINT64_MAX - 9) / 10) ? UINT64_MAX : v * 10 + (*d - '0');
+        }
+        count = v;
+        return q + 1;
+    }
+
+    /**
+     * @brief Parse a bracketed count with an optional padding byte in
+     * hexadecimal, "[N]" or "[N,HH]", ending the element. The padding byte is
+     * 0 if not given.
+     *
+     * @return false if not a bracketed count with padding
+     */
+    bool lex_bracket_padding(const char *p, const char *end, uint64_t & count, char & padding)
+    {
+        const char *q = lex_bracket_count(p, end, count, ',');
+        const char *hex;
+
+        padding = 0;
+        if ((q == NULL) || (q[-1] == ']'))
+        {
+            return q == end;
+        }
+        hex = q;
+        q = skip(hex, end, is_hex_digit);
+        if ((q == hex) || (q - hex > 2))
+        {
+            return false;
+        }
+        padding = (char)((q - hex == 2) ? (hex_value(hex[0]) << 4) | hex_value(hex[1])
+                : hex_value(hex[0]));
+        return (q + 1 == end) && (*q == ']');
+    }
+
+    /**
+     * @brief NUL-terminated copy of a number part for the C conversion
+     * functions. Usual numbers are copied on the stack.
+     */
+    class NumberString
+    {
+    private:
+        char m_small[64];
+        std::string m_large;
+        const char *m_str;
+
+    public:
+        NumberString(const char *p, size_t len)
+        {
+            if (len < sizeof(m_small))
+            {
+                memcpy(m_small, p, len);
+                m_small[len] = '\0';
+                m_str = m_small;
+            }
+            else
+            {
+                m_large.assign(p, len);
+                m_str = m_large.c_str();
+            }
+        }
+
+        const char *c_str(void) const
+        {
+            return m_str;
+        }
+    };
+
+    ///////////////////////////    INTEGER PARSING    ///////////////////////////
+
+    /**
+     * @brief Load 8 characters with the first one in the low-order byte
+     */
+    inline uint64_t load_le64(const char *p)
+    {
+        uint64_t v;
+
+        memcpy(&v, p, sizeof(v));
+        return (host_endianess == BS::little_endian) ? v : byte_swap(v);
+    }
+
+    /**
+     * @brief Convert 8 decimal digits at once
+     */
+    inline uint64_t parse_8_digits(const char *p)
+    {
+        uint64_t v = load_le64(p) - 0x3030303030303030ULL;
+
+        v = (v * 10 + (v >> 8)) & 0x00FF00FF00FF00FFULL;
+        v = (v * 100 + (v >> 16)) & 0x0000FFFF0000FFFFULL;
+        return (v * 10000 + (v >> 32)) & 0xFFFFFFFFULL;
+    }
+
+    /**
+     * @brief Convert 8 hexadecimal digits at once
+     */
+    inline uint64_t parse_8_hex_digits(const char *p)
+    {
+        uint64_t v = load_le64(p);
+
+        // letters have the bit 6 set and their low nibble is the value - 9
+        v = (v & 0x0F0F0F0F0F0F0F0FULL) + 9 * ((v >> 6) & 0x0101010101010101ULL);
+        v = ((v & 0x000F000F000F000FULL) << 4) | ((v >> 8) & 0x000F000F000F000FULL);
+        v = ((v & 0x000000FF000000FFULL) << 8) | ((v >> 16) & 0x000000FF000000FFULL);
+        return ((v & 0xFFFFULL) << 16) | ((v >> 32) & 0xFFFFULL);
+    }
+
+    /**
+     * @brief Convert 8 binary digits at once
+     */
+    inline uint64_t parse_8_bin_digits(const char *p)
+    {
+        // gather the bit 8 * i of each character to the bit 63 - i
+        return ((load_le64(p) & 0x0101010101010101ULL) * 0x8040201008040201ULL) >> 56;
+    }
+
+    /**
+     * @brief Convert valid decimal digits
+     * @param overflow will be true if the value does not fit in 64 bits
+     */
+    uint64_t parse_decimal(const char *p, const char *end, bool & overflow)
+    {
+        const char *safe_end;
+        uint64_t v = 0;
+
+        p = skip(p, end, is_zero);
+        overflow = (end - p > 20);
+        if (overflow)
+        {
+            return 0;
+        }
+        // up to 19 digits always fit in 64 bits
+        safe_end = (end - p == 20) ? end - 1 : end;
+        for (; safe_end - p >= 8; p += 8)
+        {
+            v = v * 100000000ULL + parse_8_digits(p);
+        }
+        for (; p < safe_end; ++p)
+        {
+            v = v * 10 + (*p - '0');
+        }
+        if (p < end)
+        {
+            overflow = __builtin_mul_overflow(v, 10ULL, &v) ||
+                    __builtin_add_overflow(v, (uint64_t)(*p - '0'), &v);
+        }
+        return v;
+    }
+
+    /**
+     * @brief Convert valid hexadecimal, octal or binary digits
+     * @param overflow will be true if the value does not fit in 64 bits
+     */
+    uint64_t parse_power_of_2(const char *p, const char *end, int base, bool & overflow)
+    {
+        int bits = (base == 16) ? 4 : (base == 8) ? 3 : 1;
+        uint64_t v = 0;
+
+        p = skip(p, end, is_zero);
+        // the first significant digit may need less bits than the others
+        overflow = (p < end) &&
+                ((end - p - 1) * bits + 32 - __builtin_clz(hex_value(*p)) > 64);
+        if (overflow)
+        {
+            return 0;
+        }
+        if (base == 16)
+        {
+            for (; end - p >= 8; p += 8)
+            {
+                v = (v << 32) | parse_8_hex_digits(p);
+            }
+        }
+        else if (base == 2)
+        {
+            for (; end - p >= 8; p += 8)
+            {
+                v = (v << 8) | parse_8_bin_digits(p);
+            }
+        }
+        for (; p < end; ++p)
+        {
+            v = (v << bits) | hex_value(*p);
+        }
+        return v;
+    }
+
+    // The conversions below raise std::out_of_range like std::stoull and
+    // std::stoll do. The digits are already checked by the lexer.
+
+    uint64_t to_uint64(const char *p, size_t len, int base)
+    {
+        const char *end = p + len;
+        uint64_t value;
+        bool overflow;
+
+        if ((p < end) && (*p == '+'))
+        {
+            ++p;
+        }
+        if (base == 10)
+        {
+            value = parse_decimal(p, end, overflow);
+        }
+        else
+        {
+            value = parse_power_of_2(p, end, base, overflow);
+        }
+        if (overflow)
+        {
+            throw std::out_of_range("stoull");
+        }
+        return value;
+    }
+
+    /**
+     * @brief Convert a negative decimal number
+     */
+    int64_t to_int64(const char *p, size_t len)
+    {
+        uint64_t magnitude;
+        bool overflow;
+
+        magnitude = parse_decimal(p + 1, p + len, overflow);
+        if (overflow || (magnitude > (uint64_t)INT64_MAX + 1))
+        {
+            throw std::out_of_range("stoll");
+        }
+        return (int64_t)(0 - magnitude);
+    }
+
+    /**
+     * @brief Get the smallest size (1, 2, 4 or 8 bytes) of a number of bits
+     */
+    inline int size_of_bits(int bits)
+    {
+        int bytes = (bits + 7) / 8;
+
+        return (bytes <= 1) ? 1 : 1 << (32 - __builtin_clz(bytes - 1));
+    }
+
+    inline int unsigned_size(uint64_t value)
+    {
+        return size_of_bits(64 - __builtin_clzll(value | 1));
+    }
+
+    inline int signed_size(int64_t value)
+    {
+        uint64_t magnitude = (value < 0) ? ~(uint64_t)value : (uint64_t)value;
+
+        // one more bit for the sign
+        return size_of_bits(65 - __builtin_clzll(magnitude | 1));
+    }
+
+    //////////////////////////    FLOAT CONVERSION    ///////////////////////////
+
+    /**
+     * @brief Split valid float characters in a decimal mantissa and exponent
+     *
+     * @return false if the mantissa has more than 19 significant digits
+     */
+    bool split_float(const char *p, const char *end, uint64_t & mantissa,
+            int64_t & exponent)
+    {
+        const char *digits;
+        int64_t exp_value = 0;
+        bool exp_negative = false;
+        int count = 0;
+
+        if ((*p == '+') || (*p == '-'))
+        {
+            ++p;
+        }
+        mantissa = 0;
+        exponent = 0;
+        p = skip(p, end, is_zero);
+        for (digits = p; (p < end) && is_digit(*p); ++p, ++count)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+        }
+        if ((p < end) && (*p == '.'))
+        {
+            ++p;
+            if (count == 0)
+            {
+                digits = p;
+                p = skip(p, end, is_zero);
+                exponent = digits - p;
+            }
+            for (digits = p; (p < end) && is_digit(*p); ++p, ++count)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+            }
+            exponent -= p - digits;
+        }
+        if (count > 19)
+        {
+            return false;
+        }
+        if ((p < end) && ((*p | 0x20) == 'e'))
+        {
+            ++p;
+            if ((*p == '+') || (*p == '-'))
+            {
+                exp_negative = (*p == '-');
+                ++p;
+            }
+            // a saturated exponent still gives 0 or an overflow
+            for (; p < end; ++p)
+            {
+                exp_value = std::min<int64_t>(exp_value * 10 + (*p - '0'), 100000);
+            }
+            exponent += exp_negative ? -exp_value : exp_value;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Get the C locale used to convert the floats whatever the current
+     * locale is
+     */
+    locale_t c_locale(void)
+    {
+        static locale_t locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+        return locale;
+    }
+
+    // The conversions below are correctly rounded and do not depend on the
+    // locale. A mantissa and a power of ten both exactly representable give
+    // the result with a single operation (Clinger's fast path), other numbers
+    // use the C library in the C locale.
+    // Like std::stof and std::stod, an overflow raises std::out_of_range but a
+    // subnormal or zero result is accepted.
+
+    float32_t to_float32(const char *p, size_t len)
+    {
+        static const float32_t powers[] = {
+            1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+        };
+        uint64_t mantissa;
+        int64_t exponent;
+        float32_t value;
+
+        if (split_float(p, p + len, mantissa, exponent) &&
+                (mantissa <= (1ULL << 24)) && (exponent >= -10) && (exponent <= 10))
+        {
+            value = (float32_t)mantissa;
+            value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+            return (*p == '-') ? -value : value;
+        }
+
+        NumberString str(p, len);
+        value = strtof_l(str.c_str(), NULL, c_locale());
+        if (std::isinf(value))
+        {
+            throw std::out_of_range("stof");
+        }
+        return value;
+    }
+
+    float64_t to_float64(const char *p, size_t len)
+    {
+        static const float64_t powers[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+        uint64_t mantissa;
+        int64_t exponent;
+        float64_t value;
+
+        if (split_float(p, p + len, mantissa, exponent) &&
+                (mantissa <= (1ULL << 53)) && (exponent >= -22) && (exponent <= 22))
+        {
+            value = (float64_t)mantissa;
+            value = (exponent < 0) ? value / powers[-exponent] : value * powers[exponent];
+            return (*p == '-') ? -value : value;
+        }
+
+        NumberString str(p, len);
+        value = strtod_l(str.c_str(), NULL, c_locale());
+        if (std::isinf(value))
+        {
+            throw std::out_of_range("stod");
+        }
+        return value;
+    }
+
+    ////////////////////////////    HEX BYTES    ///////////////////////////////
+
+#ifdef __SSE2__
+    /**
+     * @brief Decode 16 canonical tokens "hh " (48 characters) at once
+     * @return false if the characters are not 16 canonical tokens
+     */
+    inline bool decode_hex_block(const char *p, char *out)
+    {
+        // byte i of a block j is a space if (16 * j + i) % 3 == 2
+        static const char layout[3][16] = {
+            {0,0,-1,0,0,-1,0,0,-1,0,0,-1,0,0,-1,0},
+            {0,-1,0,0,-1,0,0,-1,0,0,-1,0,0,-1,0,0},
+            {-1,0,0,-1,0,0,-1,0,0,-1,0,0,-1,0,0,-1},
+        };
+        const __m128i space = _mm_set1_epi8(' ');
+        const __m128i case_bit = _mm_set1_epi8(0x20);
+        const __m128i before_0 = _mm_set1_epi8('0' - 1);
+        const __m128i after_9 = _mm_set1_epi8('9' + 1);
+        const __m128i before_a = _mm_set1_epi8('a' - 1);
+        const __m128i after_f = _mm_set1_epi8('f' + 1);
+        const __m128i ten = _mm_set1_epi8('a' - 10);
+        unsigned char nibbles[48];
+        __m128i c, lower, digit, letter, expected;
+
+        for (int j = 0; j < 3; ++j)
+        {
+            c = _mm_loadu_si128((const __m128i *)(p + 16 * j));
+            lower = _mm_or_si128(c, case_bit);
+            // characters >= 0x80 are negative so they are never in range
+            digit = _mm_and_si128(_mm_cmpgt_epi8(c, before_0), _mm_cmplt_epi8(c, after_9));
+            letter = _mm_and_si128(_mm_cmpgt_epi8(lower, before_a), _mm_cmplt_epi8(lower, after_f));
+            expected = _mm_loadu_si128((const __m128i *)layout[j]);
+            if (_mm_movemask_epi8(_mm_or_si128(
+                    _mm_and_si128(expected, _mm_cmpeq_epi8(c, space)),
+                    _mm_andnot_si128(expected, _mm_or_si128(digit, letter)))) != 0xFFFF)
+            {
+                return false;
+            }
+            _mm_storeu_si128((__m128i *)(nibbles + 16 * j), _mm_or_si128(
+                    _mm_and_si128(digit, _mm_sub_epi8(c, _mm_set1_epi8('0'))),
+                    _mm_and_si128(letter, _mm_sub_epi8(lower, ten))));
+        }
+        for (int i = 0; i < 16; ++i)
+        {
+            out[i] = (char)((nibbles[3 * i] << 4) | nibbles[3 * i + 1]);
+        }
+        return true;
+    }
+#endif
+
+    ////////////////////////////    EMISSION    ////////////////////////////////
+
+    /**
+     * @brief Store the low-order bytes of a value with one unaligned store
+     */
+    template <typename UInt, BS::endianess_t Endianess>
+    inline void store(char *dst, uint64_t value)
+    {
+        UInt v = (UInt)value;
+        if (Endianess != host_endianess)
+        {
+            v = byte_swap(v);
+        }
+        memcpy(dst, &v, sizeof(v));
+    }
+
+    template <typename UInt, BS::endianess_t Endianess>
+    void store_all(char *dst, const uint64_t *values, size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            store<UInt, Endianess>(dst + i * sizeof(UInt), values[i]);
+        }
+    }
+
+    /**
+     * @brief Get the bits to write of a number. Only a 4 bytes float is not
+     * stored in the low-order bytes of value_u64 on a big-endian host.
+     */
+    inline uint64_t number_bits(const BS::number_t & number)
+    {
+        uint32_t bits;
+
+        if ((host_endianess == BS::big_endian) && number.num_float &&
+                (number.size == 4))
+        {
+            memcpy(&bits, &number.value_f32, sizeof(bits));
+            return bits;
+        }
+        return number.value_u64;
+    }
+
+    /**
+     * @brief Store a number of `size` bytes in a given endianess
+     */
+    inline void store_number(char *dst, uint64_t value, int size,
+            BS::endianess_t endianess)
+    {
+        bool big = (endianess == BS::big_endian);
+        switch(size)
+        {
+        case 1:
+            store<uint8_t, BS::little_endian>(dst, value);
+            break;
+        case 2:
+            big ? store<uint16_t, BS::big_endian>(dst, value) :
+                    store<uint16_t, BS::little_endian>(dst, value);
+            break;
+        case 4:
+            big ? store<uint32_t, BS::big_endian>(dst, value) :
+                    store<uint32_t, BS::little_endian>(dst, value);
+            break;
+        case 8:
+            big ? store<uint64_t, BS::big_endian>(dst, value) :
+                    store<uint64_t, BS::little_endian>(dst, value);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * @brief Store many numbers of `size` bytes in a given endianess
+     */
+    void store_numbers(char *dst, const uint64_t *values, size_t count,
+            int size, BS::endianess_t endianess)
+    {
+        bool big = (endianess == BS::big_endian);
+        switch(size)
+        {
+        case 1:
+            store_all<uint8_t, BS::little_endian>(dst, values, count);
+            break;
+        case 2:
+            big ? store_all<uint16_t, BS::big_endian>(dst, values, count) :
+                    store_all<uint16_t, BS::little_endian>(dst, values, count);
+            break;
+        case 4:
+            big ? store_all<uint32_t, BS::big_endian>(dst, values, count) :
+                    store_all<uint32_t, BS::little_endian>(dst, values, count);
+            break;
+        case 8:
+            big ? store_all<uint64_t, BS::big_endian>(dst, values, count) :
+                    store_all<uint64_t, BS::little_endian>(dst, values, count);
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * @brief Store a value as `size` groups of 7 bits, the low-order group
+     * first, all but the last with the continuation bit set. The number of
+     * groups is known beforehand, so the loop does not test the value.
+     */
+    template <typename T>
+    inline void store_leb128(char *dst, T value, int size)
+    {
+        for (int i = 0; i < size - 1; ++i)
+        {
+            dst[i] = (char)((value & 0x7F) | 0x80);
+            value >>= 7; // arithmetic shift for a signed value
+        }
+        dst[size - 1] = (char)(value & 0x7F);
+    }
+
+    inline int uleb128_size(uint64_t value)
+    {
+        return (64 - __builtin_clzll(value | 1) + 6) / 7;
+    }
+
+    inline int sleb128_size(int64_t value)
+    {
+        // the sign bit is in the last group
+        return (64 - __builtin_clrsbll(value) + 6) / 7;
+    }
+
+    //////////////////////////////    KEYWORDS    ///////////////////////////////
+
+    /**
+     * @brief Recognize a directive taking a count, "repeat[N]", "fill[N]",
+     * "align[N]" or "pad-to[N]", the last two with an optional padding byte
+     * "[N,HH]"
+     *
+     * @param p the element characters (without leading nor ending spaces)
+     * @param end the end of the element
+     * @param tok will contain the directive if recognized
+     * @return true if the element is a directive else false
+     */
+    bool lex_directive(const char *p, const char *end, BS::state_token_t & tok)
+    {
+        if ((end - p >= 9) && (memcmp(p, "repeat[", 7) == 0))
+        {
+            tok.type = BS::t_state_type_repeat;
+            return lex_bracket_count(p + 6, end, tok.count) == end;
+        }
+        if ((end - p >= 7) && (memcmp(p, "fill[", 5) == 0))
+        {
+            tok.type = BS::t_state_type_fill;
+            return lex_bracket_count(p + 4, end, tok.count) == end;
+        }
+        if ((end - p >= 8) && (memcmp(p, "align[", 6) == 0))
+        {
+            tok.type = BS::t_state_type_align;
+            return lex_bracket_padding(p + 5, end, tok.count, tok.padding);
+        }
+        if ((end - p >= 9) && (memcmp(p, "pad-to[", 7) == 0))
+        {
+            tok.type = BS::t_state_type_pad;
+            return lex_bracket_padding(p + 6, end, tok.count, tok.padding);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Compare the characters of an element with a keyword of the same
+     * length
+     */
+    template <size_t N>
+    inline bool matches(const char *p, const char (&keyword)[N])
+    {
+        return memcmp(p, keyword, N - 1) == 0;
+    }
+
+    /**
+     * @brief Recognize a keyword state. The length and the first character
+     * select the only possible keyword, so most other elements are rejected
+     * without any comparison.
+     *
+     * @param p the element characters (without leading nor ending spaces)
+     * @param len the element length
+     * @param tok will contain the state if recognized
+     * @return true if the element is a keyword else false
+     */
+    bool lex_keyword(const char *p, size_t len, BS::state_token_t & tok)
+    {
+        tok.type = BS::t_state_type_number;
+        switch((len << 8) | (unsigned char)((len > 0) ? p[0] : 0))
+        {
+        case (3 << 8) | 'h':
+            tok.num_type = BS::t_num_hexadecimal;
+            return matches(p, "hex");
+        case (4 << 8) | 'h':
+            tok.num_type = BS::t_num_hexadecimal;
+            return matches(p, "hexa");
+        case (11 << 8) | 'h':
+            tok.num_type = BS::t_num_hexadecimal;
+            return matches(p, "hexadecimal");
+        case (3 << 8) | 'd':
+            tok.num_type = BS::t_num_decimal;
+            return matches(p, "dec");
+        case (7 << 8) | 'd':
+            tok.num_type = BS::t_num_decimal;
+            return matches(p, "decimal");
+        case (5 << 8) | 'f':
+            tok.num_type = BS::t_num_float;
+            return matches(p, "float");
+        case (3 << 8) | 'o':
+            tok.num_type = BS::t_num_octal;
+            return matches(p, "oct");
+        case (5 << 8) | 'o':
+            tok.num_type = BS::t_num_octal;
+            return matches(p, "octal");
+        case (3 << 8) | 'b':
+            tok.num_type = BS::t_num_binary;
+            return matches(p, "bin");
+        case (6 << 8) | 'b':
+            tok.num_type = BS::t_num_binary;
+            return matches(p, "binary");
+        case (10 << 8) | 'b':
+            tok.type = BS::t_state_type_endianess;
+            tok.endianess = BS::big_endian;
+            return matches(p, "big-endian");
+        case (13 << 8) | 'l':
+            tok.type = BS::t_state_type_endianess;
+            tok.endianess = BS::little_endian;
+            return matches(p, "little-endian");
+        default:
+            return false;
+        }
+    }
+}
+
+/**
+ * @brief Check if a size is a valid number size in bytes (0, 1, 2, 4 or 8)
+ */
+bool BS::is_valid_size(int size)
+{
+    return (size == 0) || (size == 1) || (size == 2) || (size == 4) || (size == 8);
+}
+
+/**
+ * @brief Get the type of an element in one pass over its characters.
+ * This is the lexer behind get_type().
+ *
+ * @param p the element characters
+ * @param len the element length
+ * @return the detected type
+ */
+BS::type_t BS::lex_type(const char *p, size_t len)
+{
+    state_token_t state;
+    checksum_type_t checksum;
+
+    if (len == 0)
+    {
+        return t_none;
+    }
+    switch(p[0])
+    {
+    // explicit number: "%" followed by the type and some non-space characters
+    case '%':
+        if ((len < 3) || (std::find_if(p + 2, p + len, is_space) != p + len))
+        {
+            return t_error;
+        }
+        switch(p[1])
+        {
+        case 'x':
+            return t_num_hexadecimal;
+        case 'd':
+            return t_num_decimal;
+        case 'f':
+            return t_num_float;
+        case 'o':
+            return t_num_octal;
+        case 'b':
+            return t_num_binary;
+        case 'u':
+            return t_num_uleb128;
+        case 's':
+            return t_num_sleb128;
+        default:
+            return t_error;
+        }
+    case '"':
+    case '\'':
+        return t_string;
+    case ':':
+        return lex_label(p, len) ? t_label : t_error;
+    case '@':
+        return t_reference;
+    default:
+        // checksum "crc32[...]", "crc32c[...]" or "adler32[...]"
+        if (((p[0] == 'c') || (p[0] == 'a')) && checksum_name(p, p + len, checksum))
+        {
+            return t_checksum;
+        }
+        return lex_state(p, len, state) ? t_internal_state : t_none;
+    }
+}
+
+/**
+ * @brief Recognize an internal state (keyword or directive) in one pass.
+ * Leading and ending spaces are ignored. A size state "size[N]" can be found
+ * anywhere in the element and its size is provided even if not valid.
+ *
+ * @param p the element characters
+ * @param len the element length
+ * @param tok will contain the state if recognized
+ * @return true if the element is an internal state else false
+ */
+bool BS::lex_state(const char *p, size_t len, state_token_t & tok)
+{
+    const char *end = p + len;
+    const char *q;
+
+    p = skip(p, end, is_space);
+    while ((end > p) && is_space(end[-1]))
+    {
+        --end;
+    }
+    len = end - p;
+
+    // keywords and directives
+    if (lex_keyword(p, len, tok) || lex_directive(p, end, tok))
+    {
+        return true;
+    }
+
+    // size state "size[N]"
+    if (len < 7)
+    {
+        return false;
+    }
+    for (q = p; (q = (const char *)memchr(q, 's', end - q)) != NULL; ++q)
+    {
+        if ((end - q >= 7) && (memcmp(q, "size", 4) == 0) &&
+                (lex_bracket_value(q + 4, end, tok.size) != NULL))
+        {
+            tok.type = t_state_type_size;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Check the grammar of a number element of a given type and split it
+ * in one pass. The accepted grammar is, depending on the type:
+ * - hexadecimal: (%x)?[0-9a-fA-F]+(\[\d+\])?
+ * - decimal: (%d)?[+-]?\d+(\[\d+\])?
+ * - float: (%f)?[+-]?\d+\.?\d*([eE][+-]?\d+)?(\[\d+\])?
+ * - octal: (%o)?[0-7]+(\[\d+\])?
+ * - binary: (%b)?[01]+(\[\d+\])?
+ *
+ * @param p the element characters
+ * @param len the element length
+ * @param elem_type the supposed number type of the element
+ * @param tok will contain the number part and the explicit size if any
+ * @return true if the element is valid else false
+ */
+bool BS::lex_number(const char *p, size_t len, type_t elem_type, number_token_t & tok)
+{
+    const char *end = p + len;
+    const char *q;
+    char prefix;
+
+    switch(elem_type)
+    {
+    case t_num_hexadecimal:
+        prefix = 'x';
+        break;
+    case t_num_decimal:
+        prefix = 'd';
+        break;
+    case t_num_float:
+        prefix = 'f';
+        break;
+    case t_num_octal:
+        prefix = 'o';
+        break;
+    case t_num_binary:
+        prefix = 'b';
+        break;
+    case t_num_uleb128:
+        prefix = 'u';
+        break;
+    case t_num_sleb128:
+        prefix = 's';
+        break;
+    default:
+        return false;
+    }
+    if ((len >= 2) && (p[0] == '%') && (p[1] == prefix))
+    {
+        p += 2;
+    }
+
+    tok.digits = p;
+    tok.negative = false;
+    q = p;
+    if ((elem_type == t_num_decimal) || (elem_type == t_num_float) ||
+            (elem_type == t_num_sleb128))
+    {
+        if ((q < end) && ((*q == '+') || (*q == '-')))
+        {
+            tok.negative = (*q == '-');
+            ++q;
+        }
+    }
+    p = q;
+    switch(elem_type)
+    {
+    case t_num_hexadecimal:
+        q = skip(q, end, is_hex_digit);
+        break;
+    case t_num_octal:
+        q = skip(q, end, is_oct_digit);
+        break;
+    case t_num_binary:
+        q = skip(q, end, is_bin_digit);
+        break;
+    default:
+        q = skip(q, end, is_digit);
+        break;
+    }
+    if (q == p)
+    {
+        return false;
+    }
+    if (elem_type == t_num_float)
+    {
+        if ((q < end) && (*q == '.'))
+        {
+            q = skip(q + 1, end, is_digit);
+        }
+        if ((q < end) && ((*q | 0x20) == 'e'))
+        {
+            ++q;
+            if ((q < end) && ((*q == '+') || (*q == '-')))
+            {
+                ++q;
+            }
+            p = q;
+            q = skip(q, end, is_digit);
+            if (q == p)
+            {
+                return false;
+            }
+        }
+    }
+    tok.digits_len = q - tok.digits;
+
+    tok.has_size = false;
+    if (q < end)
+    {
+        q = lex_bracket_value(q, end, tok.size);
+        if (q == NULL)
+        {
+            return false;
+        }
+        tok.has_size = true;
+    }
+    return q == end;
+}
+
+/**
+ * @brief Recognize a label definition ":name". A name is made of letters,
+ * digits, '_' and '.'.
+ *
+ * @param p the element characters
+ * @param len the element length
+ * @return true if the element is a label definition else false
+ */
+bool BS::lex_label(const char *p, size_t len)
+{
+    const char *end = p + len;
+
+    return (len >= 2) && (*p == ':') && (skip(p + 1, end, is_label_char) == end);
+}
+
+/**
+ * @brief Recognize a reference to labels: "@name" is the offset of a label,
+ * "@name-base" the distance from a label to another one. An explicit size
+ * "[N]" can end the element.
+ *
+ * @param p the element characters
+ * @param len the element length
+ * @param tok will contain the labels and the explicit size if any
+ * @return true if the element is a valid reference else false
+ */
+bool BS::lex_reference(const char *p, size_t len, reference_token_t & tok)
+{
+    const char *end = p + len;
+    const char *q;
+
+    if ((len < 2) || (*p != '@'))
+    {
+        return false;
+    }
+    tok.label = p + 1;
+    q = skip(tok.label, end, is_label_char);
+    tok.label_len = q - tok.label;
+    tok.base = q;
+    tok.base_len = 0;
+    if ((q < end) && (*q == '-'))
+    {
+        tok.base = q + 1;
+        q = skip(tok.base, end, is_label_char);
+        tok.base_len = q - tok.base;
+        if (tok.base_len == 0)
+        {
+            return false;
+        }
+    }
+    tok.has_size = false;
+    if (q < end)
+    {
+        q = lex_bracket_value(q, end, tok.size);
+        tok.has_size = true;
+    }
+    return (tok.label_len > 0) && (q == end);
+}
+
+/**
+ * @brief Recognize a checksum of the output between two labels:
+ * "crc32[start:end]", "crc32c[start:end]" or "adler32[start:end]".
+ *
+ * @param p the element characters
+ * @param len the element length
+ * @param tok will contain the algorithm and the labels
+ * @return true if the element is a valid checksum else false
+ */
+bool BS::lex_checksum(const char *p, size_t len, checksum_token_t & tok)
+{
+    const char *end = p + len;
+    const char *q = checksum_name(p, end, tok.type);
+
+    if (q == NULL)
+    {
+        return false;
+    }
+    tok.start = q + 1;
+    q = skip(tok.start, end, is_label_char);
+    tok.start_len = q - tok.start;
+    if ((q == end) || (*q != ':'))
+    {
+        return false;
+    }
+    tok.end = q + 1;
+    q = skip(tok.end, end, is_label_char);
+    tok.end_len = q - tok.end;
+    return (tok.start_len > 0) && (tok.end_len > 0) &&
+            (q + 1 == end) && (*q == ']');
+}
+
+//////////////////////////////    FUNCTIONS    /////////////////////////////////
+
 /**
  * @brief Check that an element is conform to the grammar of type it is supposed
  * to be.
@@ -16,7 +1189,7 @@
 bool BS::check_grammar(const std::string & element, type_t elem_type)
 {
     bool ret(false);
-    std::regex pattern;
+    number_token_t tok;
     switch(elem_type)
     {
     case t_string:
@@ -24,28 +1197,32 @@ bool BS::check_grammar(const std::string & element, type_t elem_type)
         ret = true;
         break;
     case t_num_hexadecimal:
-        pattern = R"((%x)?[\da-fA-F]+(\[\d+\])?)";
-        ret = std::regex_match(element, pattern);
-        break;
     case t_num_decimal:
-        pattern = R"((%d)?[+-]?\d+(\[\d+\])?)";
-        ret = std::regex_match(element, pattern);
-        break;
     case t_num_float:
-        pattern = R"((%f)?[+-]?\d+\.?\d*([eE][+-]?\d+)?(\[\d+\])?)";
-        ret = std::regex_match(element, pattern);
-        break;
     case t_num_octal:
-        pattern = R"((%o)?[0-7]+(\[\d+\])?)";
-        ret = std::regex_match(element, pattern);
-        break;
     case t_num_binary:
-        pattern = R"((%b)?[01]+(\[\d+\])?)";
-        ret = std::regex_match(element, pattern);
+    case t_num_uleb128:
+    case t_num_sleb128:
+        ret = lex_number(element.data(), element.size(), elem_type, tok);
         break;
     case t_internal_state:
         ret = is_internal_state(element);
         break;
+    case t_label:
+        ret = lex_label(element.data(), element.size());
+        break;
+    case t_reference:
+        {
+            reference_token_t ref;
+            ret = lex_reference(element.data(), element.size(), ref);
+        }
+        break;
+    case t_checksum:
+        {
+            checksum_token_t checksum;
+            ret = lex_checksum(element.data(), element.size(), checksum);
+        }
+        break;
     case t_none:
         //TODO
         break;
@@ -64,94 +1241,249 @@ bool BS::check_grammar(const std::string & element, type_t elem_type)
  */
 BS::type_t BS::get_type(const std::string & element)
 {
-    type_t ret = t_none;
-    bool res_comp;
+    return lex_type(element.data(), element.size());
+}
+
+/**
+ * @brief Add a number to a binary char vector after converting it
+ *
+ * @param v the char vector to store the converted number
+ * @param number the number to convert and add (it contains the endianess
+ * and the size)
+ */
+void BS::add_number_to_vector_char(std::vector<char> & v, const number_t number)
+{
+    size_t offset = v.size();
+
+    v.resize(offset + number.size);
+    store_number(v.data() + offset, number_bits(number), number.size,
+            number.endianess);
+}
+
+/**
+ * @brief Write a number to a sink after converting it
+ *
+ * @param sink the sink receiving the converted number
+ * @param number the number to convert and write (it contains the endianess
+ * and the size)
+ */
+void BS::add_number_to_sink(Sink & sink, const number_t & number)
+{
+    char bytes[8];
+
+    store_number(bytes, number_bits(number), number.size, number.endianess);
+    sink.write(bytes, number.size);
+}
+
+/**
+ * @brief Add many numbers of the same size and endianess to a binary char
+ * vector after converting them. The vector grows only once.
+ *
+ * @param v the char vector to store the converted numbers
+ * @param values the values of the numbers (only the `size` low-order bytes
+ * of each value are used)
+ * @param count the number of values
+ * @param size the size in bytes of each number (1, 2, 4 or 8)
+ * @param endianess the endianess of the numbers
+ */
+void BS::add_numbers_to_vector_char(std::vector<char> & v, const uint64_t *values,
+        size_t count, int size, endianess_t endianess)
+{
+    size_t offset = v.size();
+
+    v.resize(offset + count * size);
+    store_numbers(v.data() + offset, values, count, size, endianess);
+}
+
+/**
+ * @brief Write many numbers of the same size and endianess to a sink after
+ * converting them. See add_numbers_to_vector_char().
+ */
+void BS::add_numbers_to_sink(Sink & sink, const uint64_t *values,
+        size_t count, int size, endianess_t endianess)
+{
+    const size_t batch = 4096 / 8;
+    size_t n;
+
+    while (count > 0)
+    {
+        n = std::min(count, batch);
+        store_numbers(sink.prepare(n * size), values, n, size, endianess);
+        sink.commit(n * size);
+        values += n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief Encode an unsigned LEB128 number
+ *
+ * @param value the value
+ * @param out will contain the bytes, it must hold MAX_LEB128_SIZE bytes
+ * @param size the number of bytes to write, padding with continuation bytes,
+ * or 0 for the smallest encoding
+ * @return the number of bytes written, 0 if the value does not fit in `size`
+ */
+size_t BS::encode_uleb128(uint64_t value, char *out, int size)
+{
+    int needed = uleb128_size(value);
+
+    if ((size > MAX_LEB128_SIZE) || ((size != 0) && (size < needed)))
+    {
+        return 0;
+    }
+    size = (size == 0) ? needed : size;
+    store_leb128<uint64_t>(out, value, size);
+    return size;
+}
+
+/**
+ * @brief Encode a signed LEB128 number. See encode_uleb128().
+ */
+size_t BS::encode_sleb128(int64_t value, char *out, int size)
+{
+    int needed = sleb128_size(value);
 
-    std::regex pattern;
+    if ((size > MAX_LEB128_SIZE) || ((size != 0) && (size < needed)))
+    {
+        return 0;
+    }
+    size = (size == 0) ? needed : size;
+    store_leb128<int64_t>(out, value, size);
+    return size;
+}
 
-    // Element is an explicit number
+/**
+ * @brief Encode many LEB128 numbers with their smallest encodings
+ *
+ * @param values the values (two's complement if signed)
+ * @param count the number of values
+ * @param is_signed signed LEB128 else unsigned
+ * @param out will contain the bytes, it must hold count * MAX_LEB128_SIZE bytes
+ * @return the number of bytes written
+ */
+size_t BS::encode_leb128s(const uint64_t *values, size_t count, bool is_signed, char *out)
+{
+    char *p = out;
+    int size;
 
-    if (starts_with(element, PREFIX_NUMBER))
+    if (is_signed)
     {
-        pattern = R"(%[fdxbo]{1}\S+)";
-        res_comp = std::regex_match(element, pattern);
-        if (!res_comp)
+        for (size_t i = 0; i < count; ++i)
         {
-            ret = t_error;
+            size = sleb128_size((int64_t)values[i]);
+            store_leb128<int64_t>(p, (int64_t)values[i], size);
+            p += size;
         }
-        else
+    }
+    else
+    {
+        for (size_t i = 0; i < count; ++i)
         {
-            if (starts_with(element, PREFIX_NUMBER_HEXADECIMAL))
-            {
-                ret = t_num_hexadecimal;
-            }
-            else if (starts_with(element, PREFIX_NUMBER_DECIMAL))
-            {
-                ret = t_num_decimal;
-            }
-            else if (starts_with(element, PREFIX_NUMBER_FLOAT))
-            {
-                ret = t_num_float;
-            }
-            else if (starts_with(element, PREFIX_NUMBER_OCTAL))
+            // most values of an array are small
+            if (values[i] < 0x80)
             {
-                ret = t_num_octal;
-            }
-            else if (starts_with(element, PREFIX_NUMBER_BINARY))
-            {
-                ret = t_num_binary;
-            }
-            else
-            {
-                ret = t_error;
+                *p++ = (char)values[i];
+                continue;
             }
+            size = uleb128_size(values[i]);
+            store_leb128<uint64_t>(p, values[i], size);
+            p += size;
         }
     }
+    return p - out;
+}
 
-    // Element is a string
+/**
+ * @brief Convert a LEB128 number element, "%u<decimal>" or "%s<decimal>",
+ * with an optional size "[N]" padding the encoding to N bytes
+ * @exception std::out_of_range the value does not fit in 64 bits
+ *
+ * @param element the element characters
+ * @param len the element length
+ * @param elem_type t_num_uleb128 or t_num_sleb128
+ * @param out will contain the bytes, it must hold MAX_LEB128_SIZE bytes
+ * @param count will contain the number of bytes
+ * @return false if the element is not valid or does not fit in its size
+ */
+bool BS::extract_leb128(const char *element, size_t len, type_t elem_type, char *out,
+        size_t & count)
+{
+    number_token_t tok;
+    int size;
 
-    else if ((starts_with(element, "\"") || starts_with(element, "\'")))
+    if (!lex_number(element, len, elem_type, tok))
     {
-        ret = t_string;
+        error_message("Invalid element '" + std::string(element, len) + "' for a LEB128 number");
+        return false;
     }
-
-    else
+    size = tok.has_size ? tok.size : 0;
+    if (tok.negative)
     {
-        // Element is an internal state
-        if (is_internal_state(element))
+        count = encode_sleb128(to_int64(tok.digits, tok.digits_len), out, size);
+    }
+    else if (elem_type == t_num_sleb128)
+    {
+        uint64_t value = to_uint64(tok.digits, tok.digits_len, 10);
+        if (value > (uint64_t)INT64_MAX)
         {
-            ret = t_internal_state;
+            throw std::out_of_range("stoll");
         }
+        count = encode_sleb128((int64_t)value, out, size);
     }
-
-    return ret;
+    else
+    {
+        count = encode_uleb128(to_uint64(tok.digits, tok.digits_len, 10), out, size);
+    }
+    if (count == 0)
+    {
+        error_message("Bad size " + std::to_string(size) + " for the LEB128 number '" +
+                std::string(element, len) + "'. Should be 1 to 10 bytes and fit the value");
+        return false;
+    }
+    return true;
 }
 
 /**
- * @brief Add a number to a binary char vector after converting it
+ * @brief Decode a line made only of 2 digits hexadecimal numbers separated by
+ * spaces, as the hexadecimal mode with a size of 0 or 1 byte would do.
+ * Runs of single-space separated numbers are decoded 16 at a time when SSE2
+ * is available.
  *
- * @param v the char vector to store the converted number
- * @param number the number to convert and add (it contains the endianess
- * and the size)
+ * @param p the line characters (without leading nor ending spaces)
+ * @param len the line length
+ * @param out will contain the bytes, it must hold (len + 1) / 3 bytes
+ * @param count will contain the number of bytes
+ * @return false if the line has another element, then out is undefined
  */
-void BS::add_number_to_vector_char(std::vector<char> & v, const number_t number)
+bool BS::decode_hex_bytes(const char *p, size_t len, char *out, size_t & count)
 {
-    char *p;
-    p = (char*)((void*)&number.value_u64);
-    if (number.endianess == big_endian)
+    const char *end = p + len;
+    char *o = out;
+
+    while (p < end)
     {
-        for (int i = number.size-1; i >= 0; --i)
+#ifdef __SSE2__
+        while ((end - p >= 48) && decode_hex_block(p, o))
         {
-            v.push_back(p[i]);
+            p += 48;
+            o += 16;
         }
-    }
-    else
-    {
-        for (int i = 0; i < number.size; ++i)
+        if (p >= end)
+        {
+            break;
+        }
+#endif
+        if ((end - p < 2) || !is_hex_digit(p[0]) || !is_hex_digit(p[1]) ||
+                ((end - p > 2) && !is_space(p[2])))
         {
-            v.push_back(p[i]);
+            return false;
         }
+        *o++ = (char)((hex_value(p[0]) << 4) | hex_value(p[1]));
+        p = skip(p + 2, end, is_space);
     }
+    count = o - out;
+    return true;
 }
 
 /**
@@ -175,43 +1507,18 @@ bool BS::is_internal_state(const std::string & element)
  */
 bool BS::get_state_type(const std::string & element, state_type_t & state_type)
 {
-    bool ret = true;
-    std::string s(element);
-    type_t tmp_type;
-    endianess_t tmp_endian;
-    int tmp_size = -1;
-
-    strip(s);
-
-    // check endianess
-
-    if (extract_endianess(s, tmp_endian))
-    {
-        state_type = t_state_type_endianess;
-    }
-
-    // check number type
-    else if (extract_number_type(s, tmp_type))
-    {
-        state_type = t_state_type_number;
-    }
+    state_token_t tok;
 
-    // check size
-    else if (extract_size(s, tmp_size))
-    {
-        state_type = t_state_type_size;
-    }
-    else if (tmp_size != -1)
+    if (!lex_state(element.data(), element.size(), tok))
     {
-        state_type = t_state_type_size;
+        return false;
     }
-
-    else
+    if ((tok.type == t_state_type_size) && !is_valid_size(tok.size))
     {
-        ret = false;
+        error_message("Bad size " + std::to_string(tok.size) + " for default size. Should be 0, 1, 2, 4 or 8");
     }
-
-    return ret;
+    state_type = tok.type;
+    return true;
 }
 
 /**
@@ -226,27 +1533,17 @@ bool BS::get_state_type(const std::string & element, state_type_t & state_type)
 bool BS::extract_size(const std::string & str_size, int & size)
 {
     bool ret(false);
-    std::string s;
-    std::regex pattern;
-    std::smatch match;
-    int value;
+    state_token_t tok;
 
-    pattern = R"(size\[(\d+)\])";
-    if ( std::regex_search((str_size).begin(), (str_size).end(), match, pattern) )
+    if (lex_state(str_size.data(), str_size.size(), tok) &&
+            (tok.type == t_state_type_size))
     {
-        s = match[1];
-        value = std::stoi(s, 0, 10);
-        if ((value == 0) || (value == 1) || (value == 2) ||
-                (value == 4) || (value == 8))
-        {
-            size = value;
-            ret = true;
-        }
-        else
+        // the bad value will be returned
+        size = tok.size;
+        ret = is_valid_size(tok.size);
+        if (!ret)
         {
-            // the bad value will be returned
-            size = value;
-            error_message("Bad size " + std::to_string(value) + " for default size. Should be 0, 1, 2, 4 or 8");
+            error_message("Bad size " + std::to_string(tok.size) + " for default size. Should be 0, 1, 2, 4 or 8");
         }
     }
     return ret;
@@ -330,13 +1627,31 @@ bool BS::extract_number_type(const std::string & str_num, type_t & num_type)
  */
 bool BS::extract_number(const std::string & element, number_t  & number,
         const type_t elem_type, const endianess_t endian, const int elem_size)
+{
+    return extract_number(element.data(), element.size(), number, elem_type,
+            endian, elem_size);
+}
+
+/**
+ * @brief Extract a number from the characters of an element.
+ * See extract_number(const std::string &, number_t &, const type_t,
+ * const endianess_t, const int).
+ *
+ * @param element the characters representing the number
+ * @param len the number of characters
+ * @param number structure will store the extracted number
+ * @param elem_type the supposed type of the element (should be a number type)
+ * @param endian the endianess will be copied in the number structure
+ * @param elem_size the size in bytes of the target element
+ * @return true if the number was extracted else false
+ */
+bool BS::extract_number(const char *element, size_t len, number_t & number,
+        const type_t elem_type, const endianess_t endian, const int elem_size)
 {
     bool ret(true);
     int base;
     bool num_signed;
-    std::string s;
-    std::regex pattern;
-    std::smatch match;
+    number_token_t tok;
     int64_t val_i64;
     uint64_t val_u64;
     float32_t val_f32;
@@ -351,8 +1666,8 @@ bool BS::extract_number(const std::string & element, number_t  & number,
         ret = false;
         error_message("Invalid target size " + std::to_string(size) + " for number to extract");
     }
-    // check number grammar
-    if (!check_grammar(element, elem_type))
+    // check number grammar and split the number part from the explicit size
+    if (!lex_number(element, len, elem_type, tok))
     {
         ret = false;
         error_message("Invalid element type " + std::to_string(elem_type) + " for number to extract");
@@ -383,24 +1698,13 @@ bool BS::extract_number(const std::string & element, number_t  & number,
             break;
         }
     }
-    // extract the number part substring and eventually the size if explicit
-    pattern = R"((%\w{1})?([+-]?[\da-fA-F]+\.?\d*[eE]?[+-]?\d*)(\[\d+\])?)";
-    if (!std::regex_search(element.begin(), element.end(), match, pattern))
-    {
-        error_message("Failed to parse element number '" + element + "'");
-        ret = false;
-    }
-    else
+    if (ret)
     {
         // get size if provided
-        s = match[3];
-        if (!s.empty())
+        if (tok.has_size)
         {
-            s = s.substr(1, s.size() - 2);
-            size = std::stoi(s, 0, 10);
+            size = tok.size;
         }
-        // get substring representing the number (with possible sign)
-        s = match[2];
     }
     // convert ASCII to number
     if (ret)
@@ -422,31 +1726,27 @@ bool BS::extract_number(const std::string & element, number_t  & number,
                 // nothing
             }
             // get the value
-            num_signed = false;
-            if (starts_with(s, "-"))
-            {
-                num_signed = true;
-            }
+            num_signed = tok.negative;
             if (size == 4)
             {
-                val_f32 = std::stof(s);
+                val_f32 = to_float32(tok.digits, tok.digits_len);
             }
             else
             {
-                val_f64 = std::stod(s);
+                val_f64 = to_float64(tok.digits, tok.digits_len);
             }
         }
         else
         {
-            if (starts_with(s, "-"))
+            if (tok.negative)
             {
                 num_signed = true;
-                val_i64 = (int64_t)std::stoll(s, 0, base);
+                val_i64 = to_int64(tok.digits, tok.digits_len);
             }
             else
             {
                 num_signed = false;
-                val_u64 = (uint64_t)std::stoull(s, 0, base);
+                val_u64 = to_uint64(tok.digits, tok.digits_len, base);
             }
         }
     }
@@ -458,15 +1758,15 @@ bool BS::extract_number(const std::string & element, number_t  & number,
         // hexa and binary depend on number of characters
         case t_num_hexadecimal:
         case t_num_binary:
-            if (s.size() > (4 * nb_char))
+            if (tok.digits_len > (4 * nb_char))
             {
                 size = 8;
             }
-            else if (s.size() > (2 * nb_char))
+            else if (tok.digits_len > (2 * nb_char))
             {
                 size = 4;
             }
-            else if (s.size() > (1 * nb_char))
+            else if (tok.digits_len > (1 * nb_char))
             {
                 size = 2;
             }
@@ -483,49 +1783,7 @@ bool BS::extract_number(const std::string & element, number_t  & number,
         // decimal and octal depend on the value
         case t_num_decimal:
         case t_num_octal:
-            int n;
-            int b;
-            if (num_signed && (elem_type == t_num_decimal))
-            {
-                int64_t bits;
-                for (int i=2; i >= 0; i--)
-                {
-                    b = std::pow(2, i);
-                    n = b * 8;
-                    bits = std::pow(2, n-1);
-                    // min (negative) and max values in bits
-                    if ((val_i64 > (bits - 1)) || (val_i64 < (-bits)))
-                    {
-                        size = b * 2;
-                        break;
-                    }
-                }
-            }
-            else if (!num_signed)
-            {
-                for (int i=2; i >= 0; i--)
-                {
-                    uint64_t ubits;
-                    b = std::pow(2, i);
-                    n = b * 8;
-                    ubits = std::pow(2, n);
-                    if (val_u64 > (ubits - 1))
-                    {
-                        size = b * 2;
-                        break;
-                    }
-                }
-            }
-            else
-            {
-                ret = false;
-                //TODO bs_log("Unexpected error (signed = %d, elem type = %d)", (int)num_signed, (int)elem_type);
-                error_message("Unexpected error (signed = " + std::to_string(num_signed)+ ", elem type = " + std::to_string(elem_type));
-            }
-            if (size == 0)
-            {
-                size = 1;
-            }
+            size = num_signed ? signed_size(val_i64) : unsigned_size(val_u64);
             break;
         default:
             error_message("Unexpected element type. This should never happen !");
@@ -538,6 +1796,7 @@ bool BS::extract_number(const std::string & element, number_t  & number,
     {
         number.is_set = true;
         number.endianess = endian;
+        number.num_float = (elem_type == t_num_float);
         if (elem_type == t_num_float)
         {
             number.size = size;
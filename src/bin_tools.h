@@ -13,16 +13,84 @@
 #include <vector>
 
 #include "bs_data.h"
+#include "bs_sink.h"
 
 namespace BS
 {
+/** Result of lexing a number element (see lex_number) */
+typedef struct
+{
+    const char *digits; /** number part without prefix nor size (sign included) */
+    size_t digits_len;
+    bool negative;      /** the number part starts with '-' */
+    bool has_size;      /** an explicit size "[N]" ends the element */
+    int size;           /** the explicit size if has_size */
+} number_token_t;
+
+/** Result of lexing an internal state element (see lex_state) */
+typedef struct
+{
+    state_type_t type;
+    endianess_t endianess; /** set if type is t_state_type_endianess */
+    type_t num_type;       /** set if type is t_state_type_number */
+    int size;              /** set if type is t_state_type_size (maybe invalid) */
+    uint64_t count;        /** set if type is t_state_type_repeat, t_state_type_fill,
+                               t_state_type_align (alignment) or t_state_type_pad (offset) */
+    char padding;          /** set if type is t_state_type_align or t_state_type_pad */
+} state_token_t;
+
+/** Result of lexing a reference element (see lex_reference) */
+typedef struct
+{
+    const char *label;  /** the referenced label */
+    size_t label_len;
+    const char *base;   /** the label the distance is taken from, if any */
+    size_t base_len;    /** 0 if the reference is an offset */
+    bool has_size;      /** an explicit size "[N]" ends the element */
+    int size;           /** the explicit size if has_size */
+} reference_token_t;
+
+/** Result of lexing a checksum element (see lex_checksum) */
+typedef struct
+{
+    checksum_type_t type;
+    const char *start;  /** the label the checksummed bytes start at */
+    size_t start_len;
+    const char *end;    /** the label the checksummed bytes end before */
+    size_t end_len;
+} checksum_token_t;
+
+type_t lex_type(const char *p, size_t len);
+bool lex_state(const char *p, size_t len, state_token_t & tok);
+bool lex_number(const char *p, size_t len, type_t elem_type, number_token_t & tok);
+bool lex_label(const char *p, size_t len);
+bool lex_reference(const char *p, size_t len, reference_token_t & tok);
+bool lex_checksum(const char *p, size_t len, checksum_token_t & tok);
+bool is_valid_size(int size);
+
 bool is_internal_state(const std::string & element);
 type_t get_type(const std::string & element);
 bool get_state_type(const std::string & element, state_type_t & state_type);
 bool check_grammar(const std::string & element, type_t elem_type);
 void add_number_to_vector_char(std::vector<char> & v, const number_t number);
+void add_number_to_sink(Sink & sink, const number_t & number);
+/** Largest LEB128 encoding of a 64 bits value */
+const int MAX_LEB128_SIZE = 10;
+
+size_t encode_uleb128(uint64_t value, char *out, int size=0);
+size_t encode_sleb128(int64_t value, char *out, int size=0);
+size_t encode_leb128s(const uint64_t *values, size_t count, bool is_signed, char *out);
+bool extract_leb128(const char *element, size_t len, type_t elem_type, char *out,
+        size_t & count);
+bool decode_hex_bytes(const char *p, size_t len, char *out, size_t & count);
+void add_numbers_to_vector_char(std::vector<char> & v, const uint64_t *values,
+        size_t count, int size, endianess_t endianess);
+void add_numbers_to_sink(Sink & sink, const uint64_t *values,
+        size_t count, int size, endianess_t endianess);
 bool extract_number(const std::string & element, number_t & number,
         const type_t elem_type, const endianess_t endian, const int size=0);
+bool extract_number(const char *element, size_t len, number_t & number,
+        const type_t elem_type, const endianess_t endian, const int size=0);
 bool extract_size(const std::string & str_size, int & size);
 bool extract_endianess(const std::string & str_endian, endianess_t & endianess);
 bool extract_number_type(const std::string & str_num, type_t & num_type);
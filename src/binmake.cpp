@@ -6,21 +6,37 @@
 // Description : Make binary file
 //============================================================================
 
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "BinStream.h"
+#include "bin_cache.h"
+#include "mapped_file.h"
+#include "pipeline.h"
+#include "work_pool.h"
 
 using namespace std;
 using namespace BS;
 
-static const string __version("V0.3");
+static const string __version("V0.4");
 
 void usage(std::string name)
 {
     cerr << "BinMake " << __version << " - Adel Daouzli - MIT License" << endl
             << endl << "Usage: " << endl
             << "\t" << name << " [options] [text_file [binary_file]]" << endl
+            << "\t" << name << " -j jobs [options] [text_file binary_file]..." << endl
             << endl << "Description:" << endl
             << "\tGenerates binary data from a text human readable description." << endl
             << "\tIf `binary_file` is not provided then the output will be stdout" << endl
@@ -30,13 +46,460 @@ void usage(std::string name)
             << "\t-h : show this help message and exit" << endl
             << "\t-v : activate verbose mode" << endl
             << "\t-o binary_file : will generate the binary output to the "
-            << "provided file name" << endl;
+            << "provided file name" << endl
+            << "\t--size : print the size in bytes of the binary output "
+            << "instead of generating it" << endl
+            << "\t--cache directory : reuse the binary output of an unchanged "
+            << "text_file from the" << endl
+            << "\t\tprovided cache directory (updated on changes)" << endl
+            << "\t-j jobs : batch mode, convert all the pairs of text_file and "
+            << "binary_file with" << endl
+            << "\t\t`jobs` threads (0 for one per processor). The pairs are "
+            << "read from" << endl
+            << "\t\tthe arguments, a manifest, or stdin if none is given" << endl
+            << "\t--manifest file : in batch mode, read the pairs from the "
+            << "provided file" << endl
+            << "\t\t(- for stdin), one pair per line (lines starting with # "
+            << "are ignored)" << endl;
+}
+
+/**
+ * @brief Check if two paths name the same existing file
+ */
+static bool same_file(const string & path1, const string & path2)
+{
+    struct stat st1;
+    struct stat st2;
+
+    return (stat(path1.c_str(), &st1) == 0) && (stat(path2.c_str(), &st2) == 0) &&
+            (st1.st_dev == st2.st_dev) && (st1.st_ino == st2.st_ino);
+}
+
+/**
+ * @brief Convert a text file to a binary file.
+ * A regular input file is memory-mapped and proceeded in place, else it is
+ * read, parsed and written on three overlapping stages. A regular output file
+ * is written through a memory mapping, stdout is written with large
+ * unbuffered writes. An output file that is the input file is replaced once
+ * the conversion is complete.
+ *
+ * @param b the BinStream to use
+ * @param input_file the input file name (stdin if empty)
+ * @param output_file the output file name (stdout if empty)
+ * @param threads the number of threads parsing a regular input file (one per
+ * processor if 0)
+ * @param output_failed if not NULL, set to true if the output file could not
+ * be opened or written
+ * @return true if success else false
+ */
+static bool convert(BinStream & b, const string & input_file, const string & output_file,
+        size_t threads=1, bool *output_failed=NULL)
+{
+    MappedFile input;
+    unique_ptr<Sink> sink;
+    MappedFileSink *mapped_sink = NULL;
+    int fd = -1;
+    int in_fd = STDIN_FILENO;
+    bool mapped;
+
+    if (!input_file.empty() && !output_file.empty() && same_file(input_file, output_file))
+    {
+        // truncating the output would truncate the input being read: write a
+        // private file next to the target of a symbolic link, with the mode
+        // of the target, then rename it over the target
+        struct stat st;
+        char *real_path = realpath(output_file.c_str(), NULL);
+        string target;
+        string temp_file;
+        vector<char> name;
+        int temp_fd;
+
+        if (real_path == NULL)
+        {
+            cerr << "Failed to open output file '" << output_file << "'" << endl;
+            return false;
+        }
+        target = real_path;
+        free(real_path);
+        name.assign(target.begin(), target.end());
+        name.insert(name.end(), ".XXXXXX", ".XXXXXX" + 8);
+        temp_fd = mkstemp(name.data());
+        if (temp_fd < 0)
+        {
+            cerr << "Failed to open output file '" << output_file << "'" << endl;
+            return false;
+        }
+        temp_file = name.data();
+        if ((stat(target.c_str(), &st) != 0) || (fchmod(temp_fd, st.st_mode & 07777) != 0))
+        {
+            cerr << "Failed to write output file '" << output_file << "'" << endl;
+            close(temp_fd);
+            unlink(temp_file.c_str());
+            return false;
+        }
+        close(temp_fd);
+        if (!convert(b, input_file, temp_file, threads))
+        {
+            unlink(temp_file.c_str());
+            return false;
+        }
+        if (rename(temp_file.c_str(), target.c_str()) != 0)
+        {
+            cerr << "Failed to write output file '" << output_file << "'" << endl;
+            unlink(temp_file.c_str());
+            return false;
+        }
+        return true;
+    }
+    mapped = !input_file.empty() && input.open(input_file);
+    if (!mapped && !input_file.empty())
+    {
+        in_fd = open(input_file.c_str(), O_RDONLY);
+        if (in_fd < 0)
+        {
+            cerr << "Failed to open input file '" << input_file << "'" << endl;
+            return false;
+        }
+    }
+    if (output_file.empty())
+    {
+        cout.flush();
+        sink.reset(new FdSink(STDOUT_FILENO));
+    }
+    else
+    {
+        fd = open(output_file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+        if (fd < 0)
+        {
+            cerr << "Failed to open output file '" << output_file << "'" << endl;
+            if (output_failed != NULL)
+            {
+                *output_failed = true;
+            }
+            if (in_fd != STDIN_FILENO)
+            {
+                close(in_fd);
+            }
+            return false;
+        }
+        try
+        {
+            // the size of the input is a fair first estimate of the output
+            mapped_sink = new MappedFileSink(fd, max(input.size(),
+                    (size_t)MappedFileSink::DEFAULT_CAPACITY));
+            sink.reset(mapped_sink);
+        }
+        catch (const BSExceptionWriteFailed &)
+        {
+            // not a regular file (e.g. a pipe)
+            sink.reset(new FdSink(fd));
+        }
+    }
+
+    try
+    {
+        if (mapped)
+        {
+            input.advise_sequential();
+            b.set_keep_input(false);
+            b.set_sink(sink.get());
+            if (threads == 1)
+            {
+                b.proceed_input(input.data(), input.size());
+            }
+            else
+            {
+                b.proceed_parallel(input.data(), input.size(), threads);
+            }
+            b.set_sink(NULL);
+            sink->flush();
+        }
+        else
+        {
+            Pipeline().run(b, in_fd, *sink);
+        }
+        b.check_references();
+        if (mapped_sink != NULL)
+        {
+            mapped_sink->close();
+        }
+    }
+    catch (const exception & e)
+    {
+        cerr << e.what() << endl;
+        if ((output_failed != NULL) && (dynamic_cast<const BSExceptionWriteFailed *>(&e) != NULL))
+        {
+            *output_failed = true;
+        }
+        b.set_sink(NULL);
+        sink.reset();
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        if (in_fd != STDIN_FILENO)
+        {
+            close(in_fd);
+        }
+        return false;
+    }
+    sink.reset();
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    if (in_fd != STDIN_FILENO)
+    {
+        close(in_fd);
+    }
+    return true;
+}
+
+/**
+ * @brief Print once a warning that a cache directory can not be used
+ */
+static void warn_cache(const string & cache_dir)
+{
+    static atomic<bool> warned(false);
+
+    if (!warned.exchange(true))
+    {
+        cerr << "WARNING: Can not use the cache directory '" << cache_dir
+                << "', converting without it" << endl;
+    }
+}
+
+/**
+ * @brief Convert a text file to a binary file using a cache of the binary
+ * outputs keyed by a hash of their text files. An unchanged text file is not
+ * converted again, its output is copied from the cache.
+ * Only a regular input file can be cached, and only an output without errors
+ * is kept in the cache. The cache is only an optimization: if its directory
+ * can not be used or written, a warning is printed once and the text file is
+ * converted without it.
+ *
+ * @param b the BinStream to use
+ * @param input_file the input file name
+ * @param output_file the output file name (stdout if empty)
+ * @param cache_dir the cache directory
+ * @param threads the number of threads parsing the input file (one per
+ * processor if 0)
+ * @return true if success else false
+ */
+static bool convert_cached(BinStream & b, const string & input_file,
+        const string & output_file, const string & cache_dir, size_t threads=1)
+{
+    BinCache cache(cache_dir, "binmake " + __version + " grammar " +
+            to_string(GRAMMAR_VERSION));
+    BinStream initial(b);
+    MappedFile input;
+    string entry;
+    string temp_path;
+    bool temp_failed = false;
+    int fd;
+
+    if (input_file.empty() || !input.open(input_file))
+    {
+        return convert(b, input_file, output_file, threads);
+    }
+    if (!cache.usable())
+    {
+        warn_cache(cache_dir);
+        return convert(b, input_file, output_file, threads);
+    }
+    entry = cache.entry(input.data(), input.size());
+    input.close();
+    if (!cache.contains(entry))
+    {
+        temp_path = cache.temp_path(entry);
+        fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd < 0)
+        {
+            warn_cache(cache_dir);
+            return convert(b, input_file, output_file, threads);
+        }
+        close(fd);
+        if (!convert(b, input_file, temp_path, threads, &temp_failed))
+        {
+            unlink(temp_path.c_str());
+            if (!temp_failed)
+            {
+                return false;
+            }
+            // the cache is full: convert again from the initial state
+            warn_cache(cache_dir);
+            b = move(initial);
+            return convert(b, input_file, output_file, threads);
+        }
+        if (!cache.fetch(temp_path, output_file))
+        {
+            cerr << "Failed to write output file '" << output_file << "'" << endl;
+            unlink(temp_path.c_str());
+            return false;
+        }
+        // an output with errors is written but not kept
+        if (b.errors() > 0)
+        {
+            unlink(temp_path.c_str());
+        }
+        else if (!cache.publish(temp_path, entry))
+        {
+            cerr << "Failed to update the cache" << endl;
+        }
+        return true;
+    }
+    if (!cache.fetch(entry, output_file))
+    {
+        cerr << "Failed to write output file '" << output_file << "'" << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read pairs of input and output file names, one pair separated by
+ * spaces per line. Empty lines and lines starting with '#' are ignored.
+ *
+ * @param in the stream to read
+ * @param name the name of the stream for the error messages
+ * @param pairs will be appended the pairs read
+ * @return true if success else false (bad line)
+ */
+static bool read_pairs(istream & in, const string & name,
+        vector<pair<string, string> > & pairs)
+{
+    string line;
+    string input_file;
+    string output_file;
+    string extra;
+    size_t number = 0;
+
+    while (getline(in, line))
+    {
+        istringstream fields(line);
+        ++number;
+        if (!(fields >> input_file) || (input_file[0] == '#'))
+        {
+            continue;
+        }
+        if (!(fields >> output_file) || (fields >> extra))
+        {
+            cerr << name << ":" << number << ": expected 'text_file binary_file'" << endl;
+            return false;
+        }
+        pairs.push_back(make_pair(input_file, output_file));
+    }
+    return true;
+}
+
+/**
+ * @brief Convert many text files to binary files at once. Each pair is
+ * converted by its own BinStream on a pool of threads. A single pair is
+ * parsed by all the threads. A pair fails if its files can not be read or
+ * written or if its text file has errors.
+ *
+ * @param pairs the input and output file names
+ * @param jobs the number of threads (one per processor if 0)
+ * @param verbose the verbose mode of the conversions
+ * @param cache_dir the cache directory (no cache if empty)
+ * @return true if all pairs succeeded else false
+ */
+static bool convert_batch(const vector<pair<string, string> > & pairs,
+        size_t jobs, bool verbose, const string & cache_dir)
+{
+    WorkPool pool(jobs);
+    size_t threads = (pairs.size() == 1) ? jobs : 1;
+    atomic<size_t> failures(0);
+    mutex report_lock;
+
+    pool.run(pairs.size(), [&](size_t i) {
+        const string & input_file = pairs[i].first;
+        const string & output_file = pairs[i].second;
+        BinStream b(verbose);
+        bool ok = cache_dir.empty() ? convert(b, input_file, output_file, threads) :
+                convert_cached(b, input_file, output_file, cache_dir, threads);
+
+        if (!ok || (b.errors() > 0))
+        {
+            lock_guard<mutex> guard(report_lock);
+            cerr << "Failed to convert '" << input_file << "' to '" << output_file
+                    << "' (" << b.errors() << " errors)" << endl;
+            ++failures;
+        }
+    });
+    if (failures > 0)
+    {
+        cerr << failures << " of " << pairs.size() << " conversions failed" << endl;
+    }
+    return failures == 0;
+}
+
+/**
+ * @brief Print the size of the binary output of a text file without
+ * generating it. As for a conversion, it fails if the text file has errors or
+ * references to undefined labels, and no size is printed.
+ *
+ * @param b the BinStream to use
+ * @param input_file the input file name (stdin if empty)
+ * @return true if success else false
+ */
+static bool print_size(BinStream & b, const string & input_file)
+{
+    MappedFile input;
+    ifstream f;
+    CountingSink counter;
+    bool mapped = !input_file.empty() && input.open(input_file);
+
+    if (!mapped && !input_file.empty())
+    {
+        f.open(input_file.c_str());
+        if (!f.is_open())
+        {
+            cerr << "Failed to open input file '" << input_file << "'" << endl;
+            return false;
+        }
+    }
+    try
+    {
+        b.set_keep_input(false);
+        b.set_sink(&counter);
+        if (mapped)
+        {
+            input.advise_sequential();
+            b.proceed_input(input.data(), input.size());
+        }
+        else
+        {
+            b.proceed_chunks(input_file.empty() ? cin.rdbuf() : f.rdbuf(),
+                    BinStream::DEFAULT_CHUNK_SIZE);
+        }
+        b.set_sink(NULL);
+        b.check_references();
+    }
+    catch (const exception & e)
+    {
+        cerr << e.what() << endl;
+        b.set_sink(NULL);
+        return false;
+    }
+    if (b.errors() > 0)
+    {
+        return false;
+    }
+    cout << counter.size() << endl;
+    return true;
 }
 
 int main(int argc, char** argv)
 {
     BinStream b;
     string output_file;
+    string cache_dir;
+    string manifest;
+    bool size_only = false;
+    bool verbose = false;
+    bool batch = false;
+    long jobs = 0;
     int argoffs = 0;
 
     // Manage options
@@ -45,9 +508,45 @@ int main(int argc, char** argv)
         if (argv[i][0] == '-')
         {
             argoffs++;
+            // print the output size with --size
+            if (string(argv[i]) == "--size")
+            {
+                size_only = true;
+            }
+            // use a cache directory with --cache DIRECTORY
+            else if ((string(argv[i]) == "--cache") && (i + 1 < argc))
+            {
+                i++;
+                argoffs++;
+                cache_dir = argv[i];
+            }
+            // batch mode with -j JOBS
+            else if ((string(argv[i]) == "-j") && (i + 1 < argc))
+            {
+                i++;
+                argoffs++;
+                batch = true;
+                char *end;
+                errno = 0;
+                jobs = strtol(argv[i], &end, 10);
+                if ((end == argv[i]) || (*end != '\0') || (errno != 0) || (jobs < 0))
+                {
+                    cerr << "Bad number of jobs '" << argv[i] << "'" << endl;
+                    return 1;
+                }
+            }
+            // read the batch pairs from a manifest with --manifest FILENAME
+            else if ((string(argv[i]) == "--manifest") && (i + 1 < argc))
+            {
+                i++;
+                argoffs++;
+                batch = true;
+                manifest = argv[i];
+            }
             // set verbose mode with -v
-            if (argv[i][1] == 'v')
+            else if (argv[i][1] == 'v')
             {
+                verbose = true;
                 b.set_verbosity(true);
             }
             // show help and exit with -h
@@ -71,43 +570,73 @@ int main(int argc, char** argv)
     }
     argc -= argoffs;
 
-    if ((argc > 1) && (argc <= 3))
+    if (batch)
     {
-        // read input data from file
-        ifstream f(argv[argoffs + 1]);
-        b << f;
-        if ((argc == 3) || (!output_file.empty()))
+        vector<pair<string, string> > pairs;
+
+        if (size_only || !output_file.empty() || (argc % 2 == 0))
+        {
+            cerr << "Batch mode expects pairs of text_file and binary_file "
+                    << "(without -o nor --size)" << endl;
+            usage(argv[0]);
+            return 1;
+        }
+        for (int i = 1; i < argc; i += 2)
+        {
+            pairs.push_back(make_pair(argv[argoffs + i], argv[argoffs + i + 1]));
+        }
+        if (manifest == "-" || (manifest.empty() && pairs.empty()))
         {
-            // write output data to file
-            if (output_file.empty())
+            if (!read_pairs(cin, "stdin", pairs))
             {
-                output_file = argv[argoffs + 2];
+                return 1;
             }
-            ofstream t(output_file.c_str());
-            b >> t;
-            t.close();
         }
-        else
+        else if (!manifest.empty())
         {
-            // write output data to stdout
-            cout << b;
+            ifstream f(manifest.c_str());
+            if (!f.is_open())
+            {
+                cerr << "Failed to open manifest '" << manifest << "'" << endl;
+                return 1;
+            }
+            if (!read_pairs(f, manifest, pairs))
+            {
+                return 1;
+            }
+        }
+        if (!convert_batch(pairs, (size_t)jobs, verbose, cache_dir))
+        {
+            return 1;
         }
     }
-    else if(argc == 1)
+    else if (size_only && (argc <= 2))
     {
-        // read input data from stdin
-        cin >> b; // can work also with b << cin;
-        if (output_file.empty())
+        if (!print_size(b, (argc == 2) ? argv[argoffs + 1] : ""))
         {
-            // write output data to stdout
-            cout << b;
+            return 1;
         }
-        else
+    }
+    else if ((argc > 1) && (argc <= 3))
+    {
+        // read input data from file
+        if ((argc == 3) && output_file.empty())
+        {
+            output_file = argv[argoffs + 2];
+        }
+        if ((cache_dir.empty() ? !convert(b, argv[argoffs + 1], output_file) :
+                !convert_cached(b, argv[argoffs + 1], output_file, cache_dir)) ||
+                (b.errors() > 0))
+        {
+            return 1;
+        }
+    }
+    else if(argc == 1)
+    {
+        // read input data from stdin
+        if (!convert(b, "", output_file) || (b.errors() > 0))
         {
-            // write output data to file
-            ofstream t(output_file.c_str());
-            b >> t;
-            t.close();
+            return 1;
         }
     }
     else
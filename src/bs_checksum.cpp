@@ -0,0 +1,517 @@
+/*
+ * bs_checksum.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define BS_CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+#include "bs_checksum.h"
+
+using namespace BS;
+
+namespace
+{
+    const uint32_t CRC32_POLY = 0xEDB88320;  // reflected 0x04C11DB7
+    const uint32_t CRC32C_POLY = 0x82F63B78; // reflected 0x1EDC6F41
+    const uint32_t ADLER_BASE = 65521;       // largest prime below 2^16
+    const size_t ADLER_NMAX = 5552;          // bytes before the sums overflow
+    const uint64_t SMALL_FILL = 4096;        // fills checksummed byte by byte
+
+    /** Tables of a reflected CRC polynomial */
+    typedef struct
+    {
+        uint32_t slice[8][256]; // slice[k][n]: CRC of n followed by k zeros
+        uint32_t x2n[32];       // x2n[k]: x^(2^k) modulo the polynomial
+    } crc_tables_t;
+
+    /**
+     * @brief Multiply two polynomials modulo the reflected polynomial `poly`
+     */
+    uint32_t multmodp(uint32_t a, uint32_t b, uint32_t poly)
+    {
+        uint32_t m = (uint32_t)1 << 31;
+        uint32_t p = 0;
+
+        for (;;)
+        {
+            if (a & m)
+            {
+                p ^= b;
+                if ((a & (m - 1)) == 0)
+                {
+                    break;
+                }
+            }
+            m >>= 1;
+            b = (b & 1) ? (b >> 1) ^ poly : b >> 1;
+        }
+        return p;
+    }
+
+    crc_tables_t make_tables(uint32_t poly)
+    {
+        crc_tables_t t;
+        uint32_t c;
+
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            c = n;
+            for (int k = 0; k < 8; ++k)
+            {
+                c = (c & 1) ? (c >> 1) ^ poly : c >> 1;
+            }
+            t.slice[0][n] = c;
+        }
+        for (uint32_t n = 0; n < 256; ++n)
+        {
+            for (int k = 1; k < 8; ++k)
+            {
+                c = t.slice[k - 1][n];
+                t.slice[k][n] = (c >> 8) ^ t.slice[0][c & 0xFF];
+            }
+        }
+        c = (uint32_t)1 << 30; // x^1
+        t.x2n[0] = c;
+        for (int k = 1; k < 32; ++k)
+        {
+            t.x2n[k] = c = multmodp(c, c, poly);
+        }
+        return t;
+    }
+
+    const crc_tables_t & crc32_tables(void)
+    {
+        static const crc_tables_t tables = make_tables(CRC32_POLY);
+        return tables;
+    }
+
+    const crc_tables_t & crc32c_tables(void)
+    {
+        static const crc_tables_t tables = make_tables(CRC32C_POLY);
+        return tables;
+    }
+
+    /**
+     * @brief Update a CRC register (neither inverted nor finalized) with bytes,
+     * 8 bytes per step
+     */
+    uint32_t crc_bytes(const crc_tables_t & t, uint32_t crc,
+            const unsigned char *p, size_t size)
+    {
+        uint32_t lo, hi;
+
+        while (size >= 8)
+        {
+            lo = crc ^ ((uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+                    ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+            hi = (uint32_t)p[4] | ((uint32_t)p[5] << 8) |
+                    ((uint32_t)p[6] << 16) | ((uint32_t)p[7] << 24);
+            crc = t.slice[7][lo & 0xFF] ^ t.slice[6][(lo >> 8) & 0xFF] ^
+                    t.slice[5][(lo >> 16) & 0xFF] ^ t.slice[4][lo >> 24] ^
+                    t.slice[3][hi & 0xFF] ^ t.slice[2][(hi >> 8) & 0xFF] ^
+                    t.slice[1][(hi >> 16) & 0xFF] ^ t.slice[0][hi >> 24];
+            p += 8;
+            size -= 8;
+        }
+        while (size-- > 0)
+        {
+            crc = t.slice[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+        }
+        return crc;
+    }
+
+    /**
+     * @brief Multiply a CRC by x^(8 * size), as if `size` zeros followed it
+     */
+    uint32_t crc_shift(const crc_tables_t & t, uint32_t poly, uint32_t crc, uint64_t size)
+    {
+        uint32_t p = (uint32_t)1 << 31; // x^0
+        unsigned k = 3;
+
+        for (; size != 0; size >>= 1, ++k)
+        {
+            if (size & 1)
+            {
+                p = multmodp(t.x2n[k & 31], p, poly);
+            }
+        }
+        return multmodp(p, crc, poly);
+    }
+
+    uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, uint64_t size2)
+    {
+        uint64_t rem = size2 % ADLER_BASE;
+        uint64_t a1 = adler1 & 0xFFFF;
+        uint64_t b1 = adler1 >> 16;
+        uint64_t a = (a1 + (adler2 & 0xFFFF) + ADLER_BASE - 1) % ADLER_BASE;
+        uint64_t b = (b1 + (adler2 >> 16) + rem * a1 + ADLER_BASE - rem) % ADLER_BASE;
+
+        return (uint32_t)(a | (b << 16));
+    }
+
+#ifdef BS_CHECKSUM_X86
+    bool has_sse42(void)
+    {
+        static const bool supported = (__builtin_cpu_init(), __builtin_cpu_supports("sse4.2"));
+        return supported;
+    }
+
+    bool has_pclmul(void)
+    {
+        static const bool supported = (__builtin_cpu_init(),
+                __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("pclmul"));
+        return supported;
+    }
+
+    /**
+     * @brief Update a CRC-32C register with the crc32 instruction, 8 bytes at once
+     */
+    __attribute__((target("sse4.2")))
+    uint32_t crc32c_sse42(uint32_t crc, const unsigned char *p, size_t size)
+    {
+        uint64_t c, v;
+
+        while ((size > 0) && (((uintptr_t)p & 7) != 0))
+        {
+            crc = _mm_crc32_u8(crc, *p++);
+            --size;
+        }
+        c = crc;
+        while (size >= 8)
+        {
+            memcpy(&v, p, 8);
+            c = _mm_crc32_u64(c, v);
+            p += 8;
+            size -= 8;
+        }
+        crc = (uint32_t)c;
+        while (size-- > 0)
+        {
+            crc = _mm_crc32_u8(crc, *p++);
+        }
+        return crc;
+    }
+
+    /**
+     * @brief Update a CRC-32 register by folding 64 bytes per step with
+     * carry-less multiplications ("Fast CRC Computation for Generic Polynomials
+     * Using PCLMULQDQ Instruction", Intel).
+     * The size is at least 64 and a multiple of 16.
+     */
+    __attribute__((target("sse4.1,pclmul")))
+    uint32_t crc32_pclmul(uint32_t crc, const unsigned char *p, size_t size)
+    {
+        const __m128i k1k2 = _mm_set_epi64x(0x01C6E41596, 0x0154442BD4);
+        const __m128i k3k4 = _mm_set_epi64x(0x00CCAA009E, 0x01751997D0);
+        const __m128i k5k0 = _mm_set_epi64x(0, 0x0163CD6124);
+        const __m128i poly = _mm_set_epi64x(0x01F7011641, 0x01DB710641);
+        const __m128i low32 = _mm_setr_epi32(~0, 0, ~0, 0);
+        __m128i x1, x2, x3, x4, x5, x6, x7, x8;
+
+        x1 = _mm_loadu_si128((const __m128i *)(p + 0x00));
+        x2 = _mm_loadu_si128((const __m128i *)(p + 0x10));
+        x3 = _mm_loadu_si128((const __m128i *)(p + 0x20));
+        x4 = _mm_loadu_si128((const __m128i *)(p + 0x30));
+        x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+        p += 64;
+        size -= 64;
+
+        // fold 4 blocks of 16 bytes in parallel
+        while (size >= 64)
+        {
+            x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+            x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+            x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+            x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+            x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+            x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+            x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, x5),
+                    _mm_loadu_si128((const __m128i *)(p + 0x00)));
+            x2 = _mm_xor_si128(_mm_xor_si128(x2, x6),
+                    _mm_loadu_si128((const __m128i *)(p + 0x10)));
+            x3 = _mm_xor_si128(_mm_xor_si128(x3, x7),
+                    _mm_loadu_si128((const __m128i *)(p + 0x20)));
+            x4 = _mm_xor_si128(_mm_xor_si128(x4, x8),
+                    _mm_loadu_si128((const __m128i *)(p + 0x30)));
+            p += 64;
+            size -= 64;
+        }
+
+        // fold the 4 blocks into one
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+        x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+        // fold the remaining blocks of 16 bytes
+        while (size >= 16)
+        {
+            x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+            x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+            x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i *)p)), x5);
+            p += 16;
+            size -= 16;
+        }
+
+        // fold 128 bits to 64 bits
+        x2 = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_and_si128(x1, low32);
+        x1 = _mm_xor_si128(_mm_clmulepi64_si128(x1, k5k0, 0x00), x2);
+
+        // Barrett reduction to 32 bits
+        x2 = _mm_and_si128(x1, low32);
+        x2 = _mm_clmulepi64_si128(x2, poly, 0x10);
+        x2 = _mm_and_si128(x2, low32);
+        x2 = _mm_clmulepi64_si128(x2, poly, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+        return (uint32_t)_mm_extract_epi32(x1, 1);
+    }
+#endif
+
+    uint32_t crc32_update(uint32_t crc, const unsigned char *p, size_t size)
+    {
+#ifdef BS_CHECKSUM_X86
+        size_t folded;
+
+        if ((size >= 64) && has_pclmul())
+        {
+            folded = size & ~(size_t)15;
+            crc = crc32_pclmul(crc, p, folded);
+            p += folded;
+            size -= folded;
+        }
+#endif
+        return crc_bytes(crc32_tables(), crc, p, size);
+    }
+
+    uint32_t crc32c_update(uint32_t crc, const unsigned char *p, size_t size)
+    {
+#ifdef BS_CHECKSUM_X86
+        if (has_sse42())
+        {
+            return crc32c_sse42(crc, p, size);
+        }
+#endif
+        return crc_bytes(crc32c_tables(), crc, p, size);
+    }
+}
+
+///////////////////////////////    Checksums    ////////////////////////////////
+
+/**
+ * @brief Compute the CRC-32 (ISO-HDLC, as zip and png) of a buffer
+ *
+ * @param crc the CRC-32 of the previous bytes (0 if none)
+ * @param data the bytes
+ * @param size the number of bytes
+ * @return the CRC-32 of the previous bytes followed by the buffer
+ */
+uint32_t BS::crc32(uint32_t crc, const char *data, size_t size)
+{
+    return ~crc32_update(~crc, (const unsigned char *)data, size);
+}
+
+/**
+ * @brief Compute the CRC-32C (Castagnoli, as iSCSI and ext4) of a buffer
+ *
+ * @param crc the CRC-32C of the previous bytes (0 if none)
+ * @param data the bytes
+ * @param size the number of bytes
+ * @return the CRC-32C of the previous bytes followed by the buffer
+ */
+uint32_t BS::crc32c(uint32_t crc, const char *data, size_t size)
+{
+    return ~crc32c_update(~crc, (const unsigned char *)data, size);
+}
+
+/**
+ * @brief Compute the Adler-32 (as zlib) of a buffer
+ *
+ * @param adler the Adler-32 of the previous bytes (1 if none)
+ * @param data the bytes
+ * @param size the number of bytes
+ * @return the Adler-32 of the previous bytes followed by the buffer
+ */
+uint32_t BS::adler32(uint32_t adler, const char *data, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    uint32_t a = adler & 0xFFFF;
+    uint32_t b = adler >> 16;
+    size_t n;
+
+    while (size > 0)
+    {
+        n = (size < ADLER_NMAX) ? size : ADLER_NMAX;
+        size -= n;
+        for (; n >= 4; n -= 4, p += 4)
+        {
+            a += p[0]; b += a;
+            a += p[1]; b += a;
+            a += p[2]; b += a;
+            a += p[3]; b += a;
+        }
+        for (; n > 0; --n)
+        {
+            a += *p++;
+            b += a;
+        }
+        a %= ADLER_BASE;
+        b %= ADLER_BASE;
+    }
+    return a | (b << 16);
+}
+
+BS::Checksums::Checksums(void)
+        : m_crc32(0), m_crc32c(0), m_adler32(1)
+{
+}
+
+/**
+ * @brief Append bytes to the sequence
+ *
+ * @param data the bytes
+ * @param size the number of bytes
+ */
+void BS::Checksums::update(const char *data, size_t size)
+{
+    m_crc32 = crc32(m_crc32, data, size);
+    m_crc32c = crc32c(m_crc32c, data, size);
+    m_adler32 = adler32(m_adler32, data, size);
+}
+
+/**
+ * @brief Append a pattern repeated `count` times to the sequence. Large fills
+ * are not gone through: the checksums of the repetitions are combined by
+ * doubling.
+ *
+ * @param pattern the bytes to repeat
+ * @param size the size of the pattern
+ * @param count the number of repetitions
+ */
+void BS::Checksums::update(const char *pattern, size_t size, uint64_t count)
+{
+    Checksums block; // checksums of the pattern repeated 2^k times
+    Checksums fill;  // checksums of the repetitions combined so far
+    const crc_tables_t & t32 = crc32_tables();
+    const crc_tables_t & t32c = crc32c_tables();
+    uint64_t block_size = size;
+    uint64_t total = 0;
+
+    if ((size == 0) || (count <= SMALL_FILL / size))
+    {
+        for (uint64_t i = 0; i < count; ++i)
+        {
+            update(pattern, size);
+        }
+        return;
+    }
+    block.update(pattern, size);
+    for (; count != 0; count >>= 1)
+    {
+        if (count & 1)
+        {
+            fill.m_crc32 = crc_shift(t32, CRC32_POLY, fill.m_crc32, block_size) ^ block.m_crc32;
+            fill.m_crc32c = crc_shift(t32c, CRC32C_POLY, fill.m_crc32c, block_size) ^ block.m_crc32c;
+            fill.m_adler32 = adler32_combine(fill.m_adler32, block.m_adler32, block_size);
+            total += block_size;
+        }
+        if (count > 1)
+        {
+            block.m_crc32 ^= crc_shift(t32, CRC32_POLY, block.m_crc32, block_size);
+            block.m_crc32c ^= crc_shift(t32c, CRC32C_POLY, block.m_crc32c, block_size);
+            block.m_adler32 = adler32_combine(block.m_adler32, block.m_adler32, block_size);
+            block_size *= 2;
+        }
+    }
+    m_crc32 = crc_shift(t32, CRC32_POLY, m_crc32, total) ^ fill.m_crc32;
+    m_crc32c = crc_shift(t32c, CRC32C_POLY, m_crc32c, total) ^ fill.m_crc32c;
+    m_adler32 = adler32_combine(m_adler32, fill.m_adler32, total);
+}
+
+/**
+ * @brief Account for zeros of the sequence replaced afterwards by other bytes
+ *
+ * @param data the new bytes
+ * @param size the number of bytes
+ * @param after the number of bytes of the sequence following them
+ */
+void BS::Checksums::patch(const char *data, size_t size, uint64_t after)
+{
+    const unsigned char *p = (const unsigned char *)data;
+    const crc_tables_t & t32 = crc32_tables();
+    const crc_tables_t & t32c = crc32c_tables();
+    // the CRCs are linear: the change is the CRC of the difference
+    uint32_t diff32 = crc_bytes(t32, 0, p, size);
+    uint32_t diff32c = crc_bytes(t32c, 0, p, size);
+    // each byte is summed once in A and once per following byte in B
+    uint64_t a = m_adler32 & 0xFFFF;
+    uint64_t b = m_adler32 >> 16;
+
+    m_crc32 ^= crc_shift(t32, CRC32_POLY, diff32, after);
+    m_crc32c ^= crc_shift(t32c, CRC32C_POLY, diff32c, after);
+    for (size_t i = 0; i < size; ++i)
+    {
+        a = (a + p[i]) % ADLER_BASE;
+        b = (b + ((after + size - i) % ADLER_BASE) * p[i]) % ADLER_BASE;
+    }
+    m_adler32 = (uint32_t)(a | (b << 16));
+}
+
+/**
+ * @brief Get the checksums of the end of the sequence
+ *
+ * @param prefix the checksums of the beginning of the sequence
+ * @param size the number of bytes following the prefix
+ * @return the checksums of the bytes following the prefix
+ */
+BS::Checksums BS::Checksums::suffix(const Checksums & prefix, uint64_t size) const
+{
+    Checksums s;
+    uint64_t rem = size % ADLER_BASE;
+    uint64_t a1 = prefix.m_adler32 & 0xFFFF;
+    uint64_t b1 = prefix.m_adler32 >> 16;
+    uint64_t a = m_adler32 & 0xFFFF;
+    uint64_t b = m_adler32 >> 16;
+
+    // reverse of the combination of the prefix and the suffix
+    s.m_crc32 = m_crc32 ^ crc_shift(crc32_tables(), CRC32_POLY, prefix.m_crc32, size);
+    s.m_crc32c = m_crc32c ^ crc_shift(crc32c_tables(), CRC32C_POLY, prefix.m_crc32c, size);
+    a = (a + ADLER_BASE - a1 + 1) % ADLER_BASE;
+    b = (b + 2 * ADLER_BASE - b1 - (rem * a1) % ADLER_BASE + rem) % ADLER_BASE;
+    s.m_adler32 = (uint32_t)(a | (b << 16));
+    return s;
+}
+
+/**
+ * @brief Get one of the checksums
+ *
+ * @param type the checksum algorithm
+ */
+uint32_t BS::Checksums::value(checksum_type_t type) const
+{
+    switch (type)
+    {
+    case t_checksum_crc32:
+        return m_crc32;
+    case t_checksum_crc32c:
+        return m_crc32c;
+    default:
+        return m_adler32;
+    }
+}
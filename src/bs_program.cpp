@@ -0,0 +1,204 @@
+/*
+ * bs_program.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <cstring>
+
+#include "bs_exception.h"
+#include "bs_program.h"
+
+using namespace BS;
+
+////////////////////////////////    Program    /////////////////////////////////
+
+BS::Program::Program(void)
+        : m_bytes(), m_ops(), m_size(0)
+{
+}
+
+/**
+ * @brief Append literal bytes, extending the last run if possible
+ *
+ * @param data the bytes to append
+ * @param size the number of bytes
+ */
+void BS::Program::add_bytes(const char *data, size_t size)
+{
+    op_t op;
+
+    if (size == 0)
+    {
+        return;
+    }
+    if (m_ops.empty() || (m_ops.back().code != op_bytes))
+    {
+        op.code = op_bytes;
+        op.value = 0;
+        op.length = 0;
+        op.count = 1;
+        m_ops.push_back(op);
+    }
+    m_ops.back().length += size;
+    m_bytes.insert(m_bytes.end(), data, data + size);
+    m_size += size;
+}
+
+/**
+ * @brief Append a pattern repeated many times, stored once
+ *
+ * @param pattern the bytes to repeat
+ * @param size the size of the pattern
+ * @param count the number of repetitions
+ */
+void BS::Program::add_fill(const char *pattern, size_t size, uint64_t count)
+{
+    op_t op;
+
+    if (count == 1)
+    {
+        add_bytes(pattern, size);
+        return;
+    }
+    if ((size == 0) || (count == 0))
+    {
+        return;
+    }
+    op.code = op_fill;
+    op.value = 0;
+    op.length = size;
+    op.count = count;
+    m_ops.push_back(op);
+    m_bytes.insert(m_bytes.end(), pattern, pattern + size);
+    m_size += size * count;
+}
+
+/**
+ * @brief Append a mode change
+ *
+ * @param code the mode to change
+ * @param value the new value of the mode
+ */
+void BS::Program::add_mode(opcode_t code, int value)
+{
+    op_t op;
+
+    op.code = code;
+    op.value = value;
+    op.length = 0;
+    op.count = 0;
+    m_ops.push_back(op);
+}
+
+/**
+ * @brief Overwrite output bytes of a literal run, as Sink::patch() does
+ * @exception BSExceptionPatchFailed the bytes are not in a single literal run
+ *
+ * @param back how far back from the end of the output the bytes start
+ * @param data the new bytes
+ * @param size the number of bytes
+ */
+void BS::Program::patch(uint64_t back, const char *data, size_t size)
+{
+    uint64_t offset = m_size - back; // in the output
+    uint64_t output = 0;
+    uint64_t stored = 0;
+
+    if ((back > m_size) || (size > back))
+    {
+        throw BSExceptionPatchFailed(back);
+    }
+    for (const op_t & op : m_ops)
+    {
+        if ((op.code == op_bytes) && (offset >= output) &&
+                (offset + size <= output + op.length))
+        {
+            memcpy(m_bytes.data() + stored + (offset - output), data, size);
+            return;
+        }
+        if ((op.code == op_bytes) || (op.code == op_fill))
+        {
+            output += op.length * op.count;
+            stored += op.length;
+        }
+    }
+    throw BSExceptionPatchFailed(back);
+}
+
+/**
+ * @brief Write the bytes of the program to a sink.
+ * The mode changes are ignored (see BinStream::run() to apply them).
+ *
+ * @param sink the sink receiving the bytes
+ */
+void BS::Program::run(Sink & sink) const
+{
+    const char *p = m_bytes.data();
+
+    for (const op_t & op : m_ops)
+    {
+        if (op.code == op_bytes)
+        {
+            sink.write(p, op.length);
+            p += op.length;
+        }
+        else if (op.code == op_fill)
+        {
+            sink.fill(p, op.length, op.count);
+            p += op.length;
+        }
+    }
+}
+
+/**
+ * @brief Get the size in bytes of the output of the program
+ */
+uint64_t BS::Program::size(void) const
+{
+    return m_size;
+}
+
+const std::vector<BS::Program::op_t>& BS::Program::ops(void) const
+{
+    return m_ops;
+}
+
+const std::vector<char>& BS::Program::bytes(void) const
+{
+    return m_bytes;
+}
+
+//////////////////////////////    ProgramSink    ///////////////////////////////
+
+BS::ProgramSink::ProgramSink(Program & program)
+        : m_program(program)
+{
+}
+
+void BS::ProgramSink::write(const char *data, size_t size)
+{
+    m_program.add_bytes(data, size);
+}
+
+void BS::ProgramSink::fill(const char *pattern, size_t size, uint64_t count)
+{
+    m_program.add_fill(pattern, size, count);
+}
+
+void BS::ProgramSink::patch(uint64_t back, const char *data, size_t size)
+{
+    m_program.patch(back, data, size);
+}
+
+/**
+ * @brief Record a mode change
+ *
+ * @param code the mode to change
+ * @param value the new value of the mode
+ */
+void BS::ProgramSink::set_mode(Program::opcode_t code, int value)
+{
+    m_program.add_mode(code, value);
+}
@@ -0,0 +1,630 @@
+/*
+ * bs_sink.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "bs_exception.h"
+#include "bs_sink.h"
+
+using namespace BS;
+
+namespace
+{
+    /**
+     * @brief Repeat a pattern in a buffer: a single byte is set with memset,
+     * a longer pattern is copied once then the filled part is copied after
+     * itself, doubling at each step.
+     *
+     * @param dst the buffer to fill
+     * @param pattern the bytes to repeat
+     * @param size the size of the pattern
+     * @param total the size to fill, a multiple of the pattern size
+     */
+    void fill_pattern(char *dst, const char *pattern, size_t size, size_t total)
+    {
+        size_t done;
+
+        if (size == 1)
+        {
+            memset(dst, *pattern, total);
+            return;
+        }
+        done = std::min(size, total);
+        memcpy(dst, pattern, done);
+        while (done < total)
+        {
+            memcpy(dst + done, dst, std::min(done, total - done));
+            done += std::min(done, total - done);
+        }
+    }
+
+    /**
+     * @brief Overwrite bytes at the end of a buffer
+     *
+     * @param buffer the buffer
+     * @param used the number of bytes written in the buffer
+     * @param back how far back from `used` the patched bytes start
+     * @param data the new bytes
+     * @param size the number of bytes
+     * @exception BSExceptionPatchFailed the bytes are not in the buffer
+     */
+    void patch_buffer(char *buffer, size_t used, uint64_t back, const char *data,
+            size_t size)
+    {
+        if ((back > used) || (size > back))
+        {
+            throw BSExceptionPatchFailed(back);
+        }
+        memcpy(buffer + used - back, data, size);
+    }
+
+    /**
+     * @brief Get the size of a pattern repeated `count` times
+     * @exception BSExceptionFillTooLarge the size does not fit a size_t
+     */
+    size_t fill_size(size_t size, uint64_t count)
+    {
+        if ((size > 0) && (count > SIZE_MAX / size))
+        {
+            throw BSExceptionFillTooLarge(size, count);
+        }
+        return size * count;
+    }
+}
+
+/////////////////////////////////    Sink    ///////////////////////////////////
+
+/**
+ * @brief Overwrite bytes already written. By default a sink cannot go back.
+ *
+ * @param back how far back from the end of the written data the patched bytes
+ * start
+ * @param data the new bytes
+ * @param size the number of bytes (at most `back`)
+ * @exception BSExceptionPatchFailed the bytes cannot be overwritten
+ */
+void BS::Sink::patch(uint64_t back, const char *, size_t)
+{
+    throw BSExceptionPatchFailed(back);
+}
+
+/**
+ * @brief Get room to generate data in place. By default the data is
+ * generated in a scratch buffer then written by commit().
+ *
+ * @param size the maximal number of bytes to generate
+ * @return a buffer of at least `size` bytes
+ */
+char* BS::Sink::prepare(size_t size)
+{
+    if (m_scratch.size() < size)
+    {
+        m_scratch.resize(size);
+    }
+    return m_scratch.data();
+}
+
+/**
+ * @brief Append the data generated in the buffer returned by prepare()
+ *
+ * @param size the number of bytes generated (at most the prepared size)
+ */
+void BS::Sink::commit(size_t size)
+{
+    write(m_scratch.data(), size);
+}
+
+/**
+ * @brief Write a pattern repeated `count` times. By default a block of up to
+ * FILL_BLOCK_SIZE bytes is filled once and written as many times as needed.
+ * @exception BSExceptionFillTooLarge the size of the fill overflows
+ *
+ * @param pattern the bytes to repeat
+ * @param size the size of the pattern
+ * @param count the number of repetitions
+ */
+void BS::Sink::fill(const char *pattern, size_t size, uint64_t count)
+{
+    uint64_t total = fill_size(size, count);
+    std::vector<char> block;
+    size_t n;
+
+    if (total == 0)
+    {
+        return;
+    }
+    block.resize((size_t)std::min(total,
+            (uint64_t)std::max(FILL_BLOCK_SIZE / size, (size_t)1) * size));
+    fill_pattern(block.data(), pattern, size, block.size());
+    while (total > 0)
+    {
+        n = (size_t)std::min(total, (uint64_t)block.size());
+        write(block.data(), n);
+        total -= n;
+    }
+}
+
+//////////////////////////////    VectorSink    ////////////////////////////////
+
+BS::VectorSink::VectorSink(std::vector<char> & buffer)
+        : m_buffer(&buffer), m_prepared(0)
+{
+}
+
+/**
+ * @brief Make the sink append to another char vector
+ *
+ * @param buffer the char vector to append to
+ */
+void BS::VectorSink::bind(std::vector<char> & buffer)
+{
+    m_buffer = &buffer;
+}
+
+std::vector<char>& BS::VectorSink::buffer(void) const
+{
+    return *m_buffer;
+}
+
+void BS::VectorSink::write(const char *data, size_t size)
+{
+    m_buffer->insert(m_buffer->end(), data, data + size);
+}
+
+char* BS::VectorSink::prepare(size_t size)
+{
+    m_prepared = m_buffer->size();
+    m_buffer->resize(m_prepared + size);
+    return m_buffer->data() + m_prepared;
+}
+
+void BS::VectorSink::commit(size_t size)
+{
+    m_buffer->resize(m_prepared + size);
+}
+
+/**
+ * @brief Fill the pattern in place at the end of the vector, grown once
+ */
+void BS::VectorSink::fill(const char *pattern, size_t size, uint64_t count)
+{
+    size_t total = fill_size(size, count);
+
+    fill_pattern(prepare(total), pattern, size, total);
+    commit(total);
+}
+
+void BS::VectorSink::patch(uint64_t back, const char *data, size_t size)
+{
+    patch_buffer(m_buffer->data(), m_buffer->size(), back, data, size);
+}
+
+///////////////////////////    FixedBufferSink    //////////////////////////////
+
+BS::FixedBufferSink::FixedBufferSink(char *buffer, size_t capacity)
+        : m_buffer(buffer), m_capacity(capacity), m_size(0)
+{
+}
+
+/**
+ * @brief Get the number of bytes written in the buffer
+ */
+size_t BS::FixedBufferSink::size(void) const
+{
+    return m_size;
+}
+
+size_t BS::FixedBufferSink::capacity(void) const
+{
+    return m_capacity;
+}
+
+/**
+ * @brief Write data in the buffer
+ * @exception BSExceptionSinkFull the data does not fit in the buffer
+ */
+void BS::FixedBufferSink::write(const char *data, size_t size)
+{
+    if (size > m_capacity - m_size)
+    {
+        throw BSExceptionSinkFull(m_capacity);
+    }
+    memcpy(m_buffer + m_size, data, size);
+    m_size += size;
+}
+
+/**
+ * @exception BSExceptionSinkFull the data does not fit in the buffer
+ */
+char* BS::FixedBufferSink::prepare(size_t size)
+{
+    if (size > m_capacity - m_size)
+    {
+        throw BSExceptionSinkFull(m_capacity);
+    }
+    return m_buffer + m_size;
+}
+
+void BS::FixedBufferSink::commit(size_t size)
+{
+    m_size += size;
+}
+
+/**
+ * @brief Fill the pattern in place in the buffer
+ * @exception BSExceptionSinkFull the data does not fit in the buffer
+ */
+void BS::FixedBufferSink::fill(const char *pattern, size_t size, uint64_t count)
+{
+    size_t total = fill_size(size, count);
+
+    fill_pattern(prepare(total), pattern, size, total);
+    commit(total);
+}
+
+void BS::FixedBufferSink::patch(uint64_t back, const char *data, size_t size)
+{
+    patch_buffer(m_buffer, m_size, back, data, size);
+}
+
+////////////////////////////////    FdSink    //////////////////////////////////
+
+BS::FdSink::FdSink(int fd, size_t buffer_size)
+        : m_fd(fd), m_buffer(buffer_size > 0 ? buffer_size : 1), m_used(0)
+{
+}
+
+/**
+ * @brief Write the remaining buffered data. A failure is ignored, call
+ * flush() before to handle it.
+ */
+BS::FdSink::~FdSink(void)
+{
+    try
+    {
+        flush();
+    }
+    catch (const BSExceptionWriteFailed &)
+    {
+    }
+}
+
+/**
+ * @brief Write the data to the file descriptor.
+ * Data smaller than the buffer is buffered, bigger data is written at once.
+ * @exception BSExceptionWriteFailed the write failed
+ */
+void BS::FdSink::write(const char *data, size_t size)
+{
+    if (size > m_buffer.size() - m_used)
+    {
+        flush();
+        if (size >= m_buffer.size())
+        {
+            write_all(data, size);
+            return;
+        }
+    }
+    memcpy(m_buffer.data() + m_used, data, size);
+    m_used += size;
+}
+
+/**
+ * @brief Write the buffered data to the file descriptor
+ * @exception BSExceptionWriteFailed the write failed
+ */
+void BS::FdSink::flush(void)
+{
+    size_t used = m_used;
+
+    m_used = 0;
+    write_all(m_buffer.data(), used);
+}
+
+/**
+ * @brief Get room in the buffer, which is flushed or grown as needed
+ * @exception BSExceptionWriteFailed the flush failed
+ */
+char* BS::FdSink::prepare(size_t size)
+{
+    if (size > m_buffer.size() - m_used)
+    {
+        flush();
+        if (size > m_buffer.size())
+        {
+            m_buffer.resize(size);
+        }
+    }
+    return m_buffer.data() + m_used;
+}
+
+void BS::FdSink::commit(size_t size)
+{
+    m_used += size;
+}
+
+/**
+ * @brief Overwrite bytes in the buffer or, once flushed, in the file
+ * @exception BSExceptionPatchFailed the file descriptor cannot seek (e.g. a
+ * pipe) or the bytes were not written to it
+ * @exception BSExceptionWriteFailed the flush or the write failed
+ */
+void BS::FdSink::patch(uint64_t back, const char *data, size_t size)
+{
+    off_t end;
+    ssize_t n;
+
+    if (back <= m_used)
+    {
+        patch_buffer(m_buffer.data(), m_used, back, data, size);
+        return;
+    }
+    flush();
+    end = lseek(m_fd, 0, SEEK_CUR);
+    if ((end < 0) || ((uint64_t)end < back) || (size > back))
+    {
+        throw BSExceptionPatchFailed(back);
+    }
+    for (off_t offset = end - back; size > 0; offset += n)
+    {
+        n = pwrite(m_fd, data, size, offset);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                n = 0;
+                continue;
+            }
+            throw BSExceptionWriteFailed(strerror(errno));
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+void BS::FdSink::write_all(const char *data, size_t size)
+{
+    ssize_t n;
+
+    while (size > 0)
+    {
+        n = ::write(m_fd, data, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw BSExceptionWriteFailed(strerror(errno));
+        }
+        data += n;
+        size -= n;
+    }
+}
+
+////////////////////////////    MappedFileSink    //////////////////////////////
+
+/**
+ * @brief Map a file to write the data in it
+ *
+ * @param fd the file descriptor of a regular file opened for reading and
+ * writing
+ * @param capacity the initial size of the mapping (the expected size of the
+ * output if known)
+ * @exception BSExceptionWriteFailed the file could not be mapped
+ */
+BS::MappedFileSink::MappedFileSink(int fd, size_t capacity)
+        : m_fd(fd), m_data(NULL), m_capacity(0), m_size(0)
+{
+    remap(capacity > 0 ? capacity : 1);
+}
+
+/**
+ * @brief Close the sink. A failure is ignored, call close() before to handle
+ * it.
+ */
+BS::MappedFileSink::~MappedFileSink(void)
+{
+    try
+    {
+        close();
+    }
+    catch (const BSExceptionWriteFailed &)
+    {
+    }
+}
+
+/**
+ * @brief Get the number of bytes written in the file
+ */
+size_t BS::MappedFileSink::size(void) const
+{
+    return m_size;
+}
+
+/**
+ * @brief Resize the file, with its blocks allocated if the file system
+ * supports it, and its mapping
+ *
+ * @param capacity the new size of the file
+ * @exception BSExceptionWriteFailed the file could not be resized or mapped
+ */
+void BS::MappedFileSink::remap(size_t capacity)
+{
+    void *addr;
+
+    if (m_data != NULL)
+    {
+        munmap(m_data, m_capacity);
+        m_data = NULL;
+        m_capacity = 0;
+    }
+    // allocate the blocks so that a full disk fails here instead of a write
+    // in the mapping (SIGBUS)
+    if ((fallocate(m_fd, 0, 0, capacity) != 0) &&
+            (((errno != EOPNOTSUPP) && (errno != ENOSYS)) || (ftruncate(m_fd, capacity) != 0)))
+    {
+        throw BSExceptionWriteFailed(strerror(errno));
+    }
+    addr = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        throw BSExceptionWriteFailed(strerror(errno));
+    }
+    m_data = (char *)addr;
+    m_capacity = capacity;
+}
+
+/**
+ * @brief Copy the data in the mapping, growing the file if needed
+ * @exception BSExceptionWriteFailed the file could not be grown
+ */
+void BS::MappedFileSink::write(const char *data, size_t size)
+{
+    if (size > m_capacity - m_size)
+    {
+        remap(std::max(2 * m_capacity, m_size + size));
+    }
+    memcpy(m_data + m_size, data, size);
+    m_size += size;
+}
+
+/**
+ * @brief Get room in the mapping, growing the file if needed
+ * @exception BSExceptionWriteFailed the file could not be grown
+ */
+char* BS::MappedFileSink::prepare(size_t size)
+{
+    if (size > m_capacity - m_size)
+    {
+        remap(std::max(2 * m_capacity, m_size + size));
+    }
+    return m_data + m_size;
+}
+
+void BS::MappedFileSink::commit(size_t size)
+{
+    m_size += size;
+}
+
+/**
+ * @brief Fill the pattern in place in the mapping, grown once
+ * @exception BSExceptionWriteFailed the file could not be grown
+ */
+void BS::MappedFileSink::fill(const char *pattern, size_t size, uint64_t count)
+{
+    size_t total = fill_size(size, count);
+
+    fill_pattern(prepare(total), pattern, size, total);
+    commit(total);
+}
+
+void BS::MappedFileSink::patch(uint64_t back, const char *data, size_t size)
+{
+    patch_buffer(m_data, m_size, back, data, size);
+}
+
+/**
+ * @brief Unmap the file and truncate it to the size of the written data
+ * @exception BSExceptionWriteFailed the file could not be truncated
+ */
+void BS::MappedFileSink::close(void)
+{
+    if (m_data == NULL)
+    {
+        return;
+    }
+    munmap(m_data, m_capacity);
+    m_data = NULL;
+    m_capacity = 0;
+    if (ftruncate(m_fd, m_size) != 0)
+    {
+        throw BSExceptionWriteFailed(strerror(errno));
+    }
+}
+
+/////////////////////////////    CallbackSink    ///////////////////////////////
+
+BS::CallbackSink::CallbackSink(callback_t callback)
+        : m_callback(callback)
+{
+}
+
+void BS::CallbackSink::write(const char *data, size_t size)
+{
+    m_callback(data, size);
+}
+
+/////////////////////////////    CountingSink    ///////////////////////////////
+
+BS::CountingSink::CountingSink(void)
+        : m_size(0)
+{
+}
+
+/**
+ * @brief Get the number of bytes written to the sink
+ */
+uint64_t BS::CountingSink::size(void) const
+{
+    return m_size;
+}
+
+void BS::CountingSink::write(const char *, size_t size)
+{
+    m_size += size;
+}
+
+void BS::CountingSink::fill(const char *, size_t size, uint64_t count)
+{
+    m_size += fill_size(size, count);
+}
+
+void BS::CountingSink::patch(uint64_t, const char *, size_t)
+{
+}
+
+//////////////////////////////    StreamSink    ////////////////////////////////
+
+BS::StreamSink::StreamSink(std::ostream & stream)
+        : m_stream(stream)
+{
+}
+
+void BS::StreamSink::write(const char *data, size_t size)
+{
+    m_stream.write(data, size);
+}
+
+void BS::StreamSink::flush(void)
+{
+    m_stream.flush();
+}
+
+/**
+ * @brief Overwrite bytes by seeking back in the stream
+ * @exception BSExceptionPatchFailed the stream cannot seek
+ */
+void BS::StreamSink::patch(uint64_t back, const char *data, size_t size)
+{
+    std::ostream::pos_type end = m_stream.tellp();
+
+    if ((end == std::ostream::pos_type(-1)) || ((uint64_t)end < back) || (size > back) ||
+            !m_stream.seekp(end - (std::ostream::off_type)back))
+    {
+        m_stream.clear();
+        throw BSExceptionPatchFailed(back);
+    }
+    m_stream.write(data, size);
+    m_stream.seekp(end);
+}
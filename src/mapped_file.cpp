@@ -0,0 +1,114 @@
+/*
+ * mapped_file.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mapped_file.h"
+
+BS::MappedFile::MappedFile(void)
+        : m_data(NULL), m_size(0), m_open(false)
+{
+}
+
+BS::MappedFile::~MappedFile(void)
+{
+    close();
+}
+
+/**
+ * @brief Map a file in memory.
+ * Only regular files can be mapped.
+ *
+ * @param path the path of the file
+ * @return true if the file is mapped else false
+ */
+bool BS::MappedFile::open(const std::string & path)
+{
+    int fd;
+    struct stat st;
+    void *addr;
+
+    close();
+    // do not open a fifo, which would block and lose its data
+    if ((stat(path.c_str(), &st) != 0) || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+    if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode))
+    {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size > 0)
+    {
+        addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        m_data = (const char *)addr;
+        m_size = st.st_size;
+    }
+    // the mapping stays valid after closing the file
+    ::close(fd);
+    m_open = true;
+    return true;
+}
+
+/**
+ * @brief Unmap the file
+ */
+void BS::MappedFile::close(void)
+{
+    if (m_data != NULL)
+    {
+        munmap((void *)m_data, m_size);
+    }
+    m_data = NULL;
+    m_size = 0;
+    m_open = false;
+}
+
+/**
+ * @brief Advise the kernel that the mapping will be read once sequentially
+ * so it can read ahead aggressively.
+ */
+void BS::MappedFile::advise_sequential(void) const
+{
+    if (m_data != NULL)
+    {
+        madvise((void *)m_data, m_size, MADV_SEQUENTIAL);
+        madvise((void *)m_data, m_size, MADV_WILLNEED);
+    }
+}
+
+bool BS::MappedFile::is_open(void) const
+{
+    return m_open;
+}
+
+/**
+ * @brief Get the mapped content (NULL if the file is empty)
+ */
+const char *BS::MappedFile::data(void) const
+{
+    return m_data;
+}
+
+size_t BS::MappedFile::size(void) const
+{
+    return m_size;
+}
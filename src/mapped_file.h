@@ -0,0 +1,43 @@
+/*
+ * mapped_file.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace BS
+{
+    /**
+     * Read-only memory mapping of a whole file
+     */
+    class MappedFile
+    {
+    private:
+        const char *m_data;
+        size_t m_size;
+        bool m_open;
+
+        MappedFile(const MappedFile &);
+        MappedFile& operator=(const MappedFile &);
+
+    public:
+        MappedFile(void);
+        ~MappedFile(void);
+
+        bool open(const std::string & path);
+        void close(void);
+        void advise_sequential(void) const;
+
+        bool is_open(void) const;
+        const char *data(void) const;
+        size_t size(void) const;
+    };
+}
+
+#endif /* MAPPED_FILE_H_ */
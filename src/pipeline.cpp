@@ -0,0 +1,347 @@
+/*
+ * pipeline.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <poll.h>
+#include <unistd.h>
+
+#include "bs_exception.h"
+#include "pipeline.h"
+
+using namespace BS;
+
+namespace
+{
+    /**
+     * Raised in a stage waiting for another stage which failed
+     */
+    struct stopped_t
+    {
+    };
+
+    /**
+     * @brief Wait a little before trying again an operation on a ring: the
+     * thread yields first, then it sleeps if the other stage is slow
+     */
+    inline void backoff(unsigned & tries)
+    {
+        if (++tries < 64)
+        {
+            std::this_thread::yield();
+        }
+        else
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+/**
+ * Sink of the parser stage cutting the output in chunks for the writer stage
+ */
+class BS::Pipeline::ChunkSink: public Sink
+{
+private:
+    Pipeline & m_pipeline;
+    ring_t & m_free;
+    ring_t & m_filled;
+    chunk_t *m_chunk;
+
+public:
+    ChunkSink(Pipeline & pipeline, ring_t & free_chunks, ring_t & filled_chunks)
+            : m_pipeline(pipeline), m_free(free_chunks), m_filled(filled_chunks),
+              m_chunk(NULL)
+    {
+    }
+
+    virtual void write(const char *data, size_t size)
+    {
+        size_t n;
+
+        while (size > 0)
+        {
+            if (m_chunk == NULL)
+            {
+                m_chunk = m_pipeline.pop(m_free);
+                m_chunk->size = 0;
+                m_chunk->patch = 0;
+            }
+            n = std::min(size, m_chunk->data.size() - m_chunk->size);
+            memcpy(m_chunk->data.data() + m_chunk->size, data, n);
+            m_chunk->size += n;
+            data += n;
+            size -= n;
+            if (m_chunk->size == m_chunk->data.size())
+            {
+                m_pipeline.push(m_filled, m_chunk);
+                m_chunk = NULL;
+            }
+        }
+    }
+
+    /**
+     * @brief Patch the current chunk in place, or hand the patch to the writer
+     * after the current chunk when the bytes already left
+     */
+    virtual void patch(uint64_t back, const char *data, size_t size)
+    {
+        chunk_t *patch;
+
+        if (size > back)
+        {
+            throw BSExceptionPatchFailed(back);
+        }
+        if ((m_chunk != NULL) && (back <= m_chunk->size))
+        {
+            memcpy(m_chunk->data.data() + m_chunk->size - back, data, size);
+            return;
+        }
+        if (m_chunk != NULL)
+        {
+            m_pipeline.push(m_filled, m_chunk);
+            m_chunk = NULL;
+        }
+        patch = m_pipeline.pop(m_free);
+        memcpy(patch->data.data(), data, size);
+        patch->size = size;
+        patch->patch = back;
+        m_pipeline.push(m_filled, patch);
+    }
+
+    /**
+     * @brief Hand the last chunk and the end of the output to the writer
+     */
+    void finish(void)
+    {
+        if ((m_chunk != NULL) && (m_chunk->size > 0))
+        {
+            m_pipeline.push(m_filled, m_chunk);
+        }
+        m_chunk = NULL;
+        m_pipeline.push(m_filled, NULL);
+    }
+};
+
+/**
+ * @brief Create a pipeline
+ *
+ * @param chunk_size the size of the input and output chunks
+ * @param depth the number of input chunks and of output chunks, that is how
+ * far a stage can be ahead of the next one
+ */
+BS::Pipeline::Pipeline(size_t chunk_size, size_t depth)
+        : m_chunk_size(chunk_size > 0 ? chunk_size : DEFAULT_CHUNK_SIZE),
+          m_depth(depth > 0 ? depth : DEFAULT_DEPTH),
+          m_stop(false)
+{
+}
+
+/**
+ * @brief Convert an input file descriptor to a sink. The input is not kept
+ * and the output is not available in the BinStream afterwards. The file
+ * descriptor is not closed.
+ * @exception BSExceptionReadFailed the input could not be read
+ * @exception BSExceptionWriteFailed the sink could not write the output
+ * Any exception of the parsing is raised again once the stages are stopped.
+ *
+ * @param b the BinStream parsing the input
+ * @param fd the input file descriptor
+ * @param out the sink receiving the generated binary data
+ */
+void BS::Pipeline::run(BinStream & b, int fd, Sink & out)
+{
+    std::vector<chunk_t> chunks(2 * m_depth);
+    ring_t in_free(m_depth + 1);
+    ring_t in_filled(m_depth + 1);
+    ring_t out_free(m_depth + 1);
+    ring_t out_filled(m_depth + 1);
+    Sink *previous_sink = &b.sink();
+    std::string pending;
+    chunk_t *chunk;
+
+    for (size_t i = 0; i < chunks.size(); ++i)
+    {
+        chunks[i].data.resize(m_chunk_size);
+        (i < m_depth) ? in_free.push(&chunks[i]) : out_free.push(&chunks[i]);
+    }
+    m_stop = false;
+    m_error = std::exception_ptr();
+    std::thread reader(&Pipeline::read_stage, this, fd, std::ref(in_free),
+            std::ref(in_filled));
+    std::thread writer(&Pipeline::write_stage, this, std::ref(out),
+            std::ref(out_filled), std::ref(out_free));
+
+    ChunkSink sink(*this, out_free, out_filled);
+    b.set_keep_input(false);
+    b.set_sink(&sink);
+    try
+    {
+        while ((chunk = pop(in_filled)) != NULL)
+        {
+            b.proceed_chunk(chunk->data.data(), chunk->size, pending);
+            push(in_free, chunk);
+        }
+        if (!pending.empty())
+        {
+            b.proceed_line(pending.data(), pending.size());
+        }
+        sink.finish();
+    }
+    catch (const stopped_t &)
+    {
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+    b.set_sink(previous_sink);
+    reader.join();
+    writer.join();
+    if (m_error)
+    {
+        std::rethrow_exception(m_error);
+    }
+}
+
+/**
+ * @brief Record the failure of a stage and stop the other stages
+ */
+void BS::Pipeline::fail(std::exception_ptr error)
+{
+    std::lock_guard<std::mutex> guard(m_error_lock);
+
+    if (!m_error)
+    {
+        m_error = error;
+    }
+    m_stop = true;
+}
+
+/**
+ * @brief Add a chunk to a ring, waiting for room if needed
+ * @exception stopped_t another stage failed
+ */
+void BS::Pipeline::push(ring_t & ring, chunk_t *chunk)
+{
+    unsigned tries = 0;
+
+    while (!ring.push(chunk))
+    {
+        if (m_stop)
+        {
+            throw stopped_t();
+        }
+        backoff(tries);
+    }
+}
+
+/**
+ * @brief Remove a chunk from a ring, waiting for one if needed
+ * @exception stopped_t another stage failed
+ */
+BS::Pipeline::chunk_t* BS::Pipeline::pop(ring_t & ring)
+{
+    unsigned tries = 0;
+    chunk_t *chunk;
+
+    while (!ring.pop(chunk))
+    {
+        if (m_stop)
+        {
+            throw stopped_t();
+        }
+        backoff(tries);
+    }
+    return chunk;
+}
+
+/**
+ * @brief Reader stage: fill the free input chunks until the end of the input
+ */
+void BS::Pipeline::read_stage(int fd, ring_t & free_chunks, ring_t & filled_chunks)
+{
+    struct pollfd ready = {fd, POLLIN, 0};
+    chunk_t *chunk;
+    ssize_t n;
+
+    try
+    {
+        for (;;)
+        {
+            chunk = pop(free_chunks);
+            do
+            {
+                // do not stay blocked on a silent input if the others failed
+                while ((poll(&ready, 1, 100) == 0) && !m_stop)
+                {
+                }
+                if (m_stop)
+                {
+                    throw stopped_t();
+                }
+                n = read(fd, chunk->data.data(), chunk->data.size());
+            }
+            while ((n < 0) && (errno == EINTR));
+            if (n < 0)
+            {
+                throw BSExceptionReadFailed(strerror(errno));
+            }
+            if (n == 0)
+            {
+                push(filled_chunks, NULL);
+                return;
+            }
+            chunk->size = n;
+            push(filled_chunks, chunk);
+        }
+    }
+    catch (const stopped_t &)
+    {
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+}
+
+/**
+ * @brief Writer stage: write the filled output chunks to the sink until the
+ * end of the output
+ */
+void BS::Pipeline::write_stage(Sink & out, ring_t & filled_chunks, ring_t & free_chunks)
+{
+    chunk_t *chunk;
+
+    try
+    {
+        while ((chunk = pop(filled_chunks)) != NULL)
+        {
+            if (chunk->patch != 0)
+            {
+                out.patch(chunk->patch, chunk->data.data(), chunk->size);
+            }
+            else
+            {
+                out.write(chunk->data.data(), chunk->size);
+            }
+            push(free_chunks, chunk);
+        }
+        out.flush();
+    }
+    catch (const stopped_t &)
+    {
+    }
+    catch (...)
+    {
+        fail(std::current_exception());
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * pipeline.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <vector>
+
+#include "BinStream.h"
+#include "spsc_ring.h"
+
+namespace BS
+{
+    /**
+     * Conversion of an input file descriptor to a sink in three stages: a
+     * reader thread fills input chunks, the calling thread parses them and a
+     * writer thread drains the output chunks to the sink. The stages are
+     * connected by bounded lock-free rings, so reading and writing overlap
+     * with parsing.
+     */
+    class Pipeline
+    {
+    private:
+        struct chunk_t
+        {
+            std::vector<char> data;
+            size_t size;
+            uint64_t patch; // if not 0, the data patches the output this far back
+        };
+        typedef SpscRing<chunk_t *> ring_t;
+        class ChunkSink;
+
+        size_t m_chunk_size;
+        size_t m_depth;
+        std::atomic<bool> m_stop;
+        std::mutex m_error_lock;
+        std::exception_ptr m_error;
+
+        void fail(std::exception_ptr error);
+        void push(ring_t & ring, chunk_t *chunk);
+        chunk_t* pop(ring_t & ring);
+        void read_stage(int fd, ring_t & free_chunks, ring_t & filled_chunks);
+        void write_stage(Sink & out, ring_t & filled_chunks, ring_t & free_chunks);
+
+    public:
+        static const size_t DEFAULT_CHUNK_SIZE = 1024 * 1024;
+        static const size_t DEFAULT_DEPTH = 4;
+
+        Pipeline(size_t chunk_size=DEFAULT_CHUNK_SIZE, size_t depth=DEFAULT_DEPTH);
+
+        void run(BinStream & b, int fd, Sink & out);
+    };
+}
+
+#endif /* PIPELINE_H_ */
@@ -0,0 +1,97 @@
+/*
+ * spsc_ring.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace BS
+{
+    /**
+     * Bounded lock-free ring passing values from a single producer thread to
+     * a single consumer thread. push() and pop() never block, they fail when
+     * the ring is full or empty.
+     * The indexes are on their own cache lines, so a ring should not be
+     * allocated with new before C++17 (over-aligned type).
+     */
+    template <typename T>
+    class SpscRing
+    {
+    private:
+        std::vector<T> m_slots;
+        size_t m_mask;
+        alignas(64) std::atomic<size_t> m_head; // next slot to pop
+        alignas(64) std::atomic<size_t> m_tail; // next slot to push
+
+        SpscRing(const SpscRing &);
+        SpscRing& operator=(const SpscRing &);
+
+    public:
+        /**
+         * @brief Create a ring
+         *
+         * @param capacity the minimal number of values in the ring (rounded
+         * up to a power of 2)
+         */
+        SpscRing(size_t capacity)
+                : m_head(0), m_tail(0)
+        {
+            size_t size = 1;
+
+            while (size < capacity)
+            {
+                size <<= 1;
+            }
+            m_slots.resize(size);
+            m_mask = size - 1;
+        }
+
+        size_t capacity(void) const
+        {
+            return m_slots.size();
+        }
+
+        /**
+         * @brief Add a value, only from the producer thread
+         * @return false if the ring is full
+         */
+        bool push(const T & value)
+        {
+            size_t tail = m_tail.load(std::memory_order_relaxed);
+
+            if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+            {
+                return false;
+            }
+            m_slots[tail & m_mask] = value;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Remove the oldest value, only from the consumer thread
+         * @return false if the ring is empty
+         */
+        bool pop(T & value)
+        {
+            size_t head = m_head.load(std::memory_order_relaxed);
+
+            if (head == m_tail.load(std::memory_order_acquire))
+            {
+                return false;
+            }
+            value = m_slots[head & m_mask];
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+    };
+}
+
+#endif /* SPSC_RING_H_ */
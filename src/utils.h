@@ -25,6 +25,12 @@ namespace BS
     #define MAX_U16b_VALUE 0x000000000000FFFFUL
     #define MAX_U8b_VALUE  0x00000000000000FFUL
 
+    /** Check if a character is a space as in the classic locale */
+    inline bool is_space(char c)
+    {
+        return (c == ' ') || ((c >= '\t') && (c <= '\r'));
+    }
+
     bool starts_with(const std::string &s, const std::string &prefix);
     std::string& lstrip(std::string& s);
     std::string& rstrip(std::string& s);
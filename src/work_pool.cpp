@@ -0,0 +1,127 @@
+/*
+ * work_pool.cpp
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+#include "work_pool.h"
+
+using namespace BS;
+
+/**
+ * @brief Create a pool of threads
+ *
+ * @param threads the number of threads running the tasks (the number of
+ * processors if 0)
+ */
+BS::WorkPool::WorkPool(size_t threads)
+        : m_threads(threads)
+{
+    if (m_threads == 0)
+    {
+        m_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+size_t BS::WorkPool::threads(void) const
+{
+    return m_threads;
+}
+
+/**
+ * @brief Run tasks numbered from 0 to count - 1 and wait for their end.
+ * The calling thread is one of the threads of the pool. If tasks raise
+ * exceptions, the other tasks are still run and the first exception is
+ * raised again once all are done.
+ *
+ * @param count the number of tasks
+ * @param task the function running a task from its number
+ */
+void BS::WorkPool::run(size_t count, const task_t & task)
+{
+    size_t threads = std::min(m_threads, std::max(count, (size_t)1));
+    std::vector<queue_t> queues(threads);
+    std::vector<std::thread> workers;
+    std::exception_ptr error;
+    std::mutex error_lock;
+    task_t guarded = [&](size_t i) {
+        try
+        {
+            task(i);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (!error)
+            {
+                error = std::current_exception();
+            }
+        }
+    };
+
+    // consecutive tasks go to the same queue
+    for (size_t i = 0; i < count; ++i)
+    {
+        queues[i * threads / count].tasks.push_back(i);
+    }
+    for (size_t i = 1; i < threads; ++i)
+    {
+        workers.push_back(std::thread(&WorkPool::work, this, std::ref(queues),
+                i, std::cref(guarded)));
+    }
+    work(queues, 0, guarded);
+    for (std::thread & worker : workers)
+    {
+        worker.join();
+    }
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Get the next task of a thread: the first one of its own queue or
+ * else the last one of another queue
+ *
+ * @return false if there is no task left
+ */
+bool BS::WorkPool::next_task(std::vector<queue_t> & queues, size_t self, size_t & task)
+{
+    for (size_t i = 0; i < queues.size(); ++i)
+    {
+        queue_t & queue = queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> guard(queue.lock);
+
+        if (!queue.tasks.empty())
+        {
+            if (i == 0)
+            {
+                task = queue.tasks.front();
+                queue.tasks.pop_front();
+            }
+            else
+            {
+                task = queue.tasks.back();
+                queue.tasks.pop_back();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void BS::WorkPool::work(std::vector<queue_t> & queues, size_t self, const task_t & run)
+{
+    size_t task;
+
+    while (next_task(queues, self, task))
+    {
+        run(task);
+    }
+}
@@ -0,0 +1,50 @@
+/*
+ * work_pool.h
+ *
+ *  Created on: 17 oct. 2026
+ *  License: MIT License
+ */
+
+#ifndef WORK_POOL_H_
+#define WORK_POOL_H_
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace BS
+{
+    /**
+     * Pool of threads running a fixed set of tasks. The tasks are dealt to
+     * one queue per thread; a thread takes the tasks from the front of its
+     * own queue and, once it is empty, steals tasks from the back of the
+     * other queues. So a few long tasks do not leave the other threads idle.
+     */
+    class WorkPool
+    {
+    public:
+        typedef std::function<void(size_t task)> task_t;
+
+    private:
+        struct queue_t
+        {
+            std::mutex lock;
+            std::deque<size_t> tasks;
+        };
+
+        size_t m_threads;
+
+        bool next_task(std::vector<queue_t> & queues, size_t self, size_t & task);
+        void work(std::vector<queue_t> & queues, size_t self, const task_t & run);
+
+    public:
+        WorkPool(size_t threads=0);
+
+        size_t threads(void) const;
+        void run(size_t count, const task_t & task);
+    };
+}
+
+#endif /* WORK_POOL_H_ */
@@ -1,8 +1,10 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
+#include <cstring>
 #include <iostream>
 #include <sstream>
 #include <string>
+#include <unistd.h>
 #include "BinStream.h"
 #include "bin_tools.h"
 
@@ -167,3 +169,780 @@ TEST_CASE( "Check success to make binary", "[binstream]" )
         }
     }
 }
+
+TEST_CASE( "Check streaming conversion", "[binstream]" )
+{
+    string desc("big-endian 00112233\n# comment\n'a string with spaces'\n"
+            "little-endian %d1234 %f1.5\n  decimal\n300 %b01\n%xff");
+    BinStream ref;
+    vector<char> expected;
+    ref << desc;
+    ref >> expected;
+
+    SECTION( "- output is identical whatever the chunk size" )
+    {
+        for (size_t chunk_size = 1; chunk_size < desc.size() + 2; ++chunk_size)
+        {
+            BinStream b;
+            stringstream in(desc);
+            stringstream out;
+            REQUIRE( b.stream(in, out, chunk_size) );
+            string result = out.str();
+            REQUIRE( vector<char>(result.begin(), result.end()) == expected );
+        }
+    }
+
+    SECTION( "- output is not kept once streamed" )
+    {
+        BinStream b;
+        stringstream in(desc);
+        stringstream out;
+        b.stream(in, out);
+        REQUIRE( b.output_ready() == false );
+        REQUIRE( b.size() == 0 );
+        REQUIRE( b.input_ready() == false );
+    }
+}
+
+TEST_CASE( "Check ingestion from a buffer or a file", "[binstream]" )
+{
+    const char desc[] = "big-endian 0001\n  'ab'  \n# 99\ndecimal 300";
+    vector<char> expected = {0x00, 0x01, 'a', 'b', 0x01, 0x2c};
+
+    SECTION( "- proceed a buffer in place" )
+    {
+        BinStream b;
+        vector<char> output;
+        b.set_keep_input(false);
+        b.proceed_input(desc, sizeof(desc) - 1);
+        REQUIRE( b.input_ready() );
+        b >> output;
+        REQUIRE( output == expected );
+    }
+
+    SECTION( "- proceed a memory-mapped file" )
+    {
+        BinStream b;
+        vector<char> output;
+        char path[] = "/tmp/binmake_testXXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE( fd >= 0 );
+        REQUIRE( write(fd, desc, sizeof(desc) - 1) == sizeof(desc) - 1 );
+        close(fd);
+        REQUIRE( b.proceed_file(path) );
+        unlink(path);
+        b >> output;
+        REQUIRE( output == expected );
+        REQUIRE( b.proceed_file(path) == false );
+    }
+}
+
+TEST_CASE( "Check measure of the output size", "[binstream]" )
+{
+    string desc("00112233 'abc'\ndecimal 300 %d-129 %f1.5[8]\nsize[4] 1");
+    BinStream ref;
+    ref << desc;
+
+    SECTION( "- size is exact and nothing is generated" )
+    {
+        BinStream b;
+        REQUIRE( b.measure(desc) == ref.size() );
+        REQUIRE( b.output_ready() == false );
+        REQUIRE( b.input_ready() == false );
+
+        stringstream in(desc);
+        REQUIRE( b.measure(in) == ref.size() );
+    }
+
+    SECTION( "- size depends on the current modes which are left unchanged" )
+    {
+        BinStream b;
+        b << "decimal";
+        REQUIRE( b.measure("300 little-endian") == 2 );
+        b << "300";
+        REQUIRE( b.size() == 2 );
+    }
+
+    SECTION( "- output is generated in an exactly sized buffer" )
+    {
+        BinStream b;
+        vector<char> output;
+        ref >> output;
+        vector<char> buffer(b.measure(desc));
+        FixedBufferSink sink(buffer.data(), buffer.size());
+        b.set_sink(&sink);
+        b << desc;
+        REQUIRE( sink.size() == buffer.size() );
+        REQUIRE( buffer == output );
+    }
+}
+
+TEST_CASE( "Check lines of hexadecimal bytes", "[binstream]" )
+{
+    SECTION( "- long lines give the same output as word after word parsing" )
+    {
+        string line;
+        string words;
+        vector<char> expected;
+        char hex[4];
+
+        for (int i = 0; i < 300; ++i)
+        {
+            snprintf(hex, sizeof(hex), (i % 7 == 0) ? "%02X" : "%02x", (i * 37) & 0xFF);
+            line += string(hex) + ((i % 50 == 49) ? "  \t" : " ");
+            words += string(hex) + "\n";
+            expected.push_back((char)((i * 37) & 0xFF));
+        }
+        BinStream b;
+        vector<char> output;
+        b << line;
+        b >> output;
+        REQUIRE( output == expected );
+
+        BinStream ref;
+        ref << words;
+        ref >> output;
+        REQUIRE( output == expected );
+    }
+
+    SECTION( "- other lines are parsed word after word" )
+    {
+        string block;
+        for (int i = 0; i < 20; ++i)
+        {
+            block += "00 ";
+        }
+        BinStream b;
+        vector<char> output;
+        b << block + "0g " + block;
+        REQUIRE( b.size() == 40 );
+        b.reset();
+        b << block + "0102 " + block;
+        REQUIRE( b.size() == 42 );
+        b.reset();
+        b << "size[2] " + block;
+        REQUIRE( b.size() == 40 );
+        b.reset();
+        b << "little-endian\nsize[2]\n" + block + "\nsize[1]\n" + block;
+        REQUIRE( b.size() == 60 );
+        b.reset();
+        b << "decimal\n10 20";
+        b >> output;
+        REQUIRE( output == vector<char>({10, 20}) );
+    }
+
+    SECTION( "- an exactly sized buffer is enough" )
+    {
+        char buffer[2];
+        FixedBufferSink sink(buffer, sizeof(buffer));
+        BinStream b;
+        b.set_sink(&sink);
+        b << "aa          bb";
+        REQUIRE( sink.size() == 2 );
+        REQUIRE( buffer[1] == (char)0xbb );
+    }
+}
+
+TEST_CASE( "Check move and output handoff", "[binstream]" )
+{
+    SECTION( "- move construction and assignment do not copy the output" )
+    {
+        BinStream a;
+        a << "decimal big-endian" << "%d1[2] 'abc'";
+        const char *data = a.data();
+
+        BinStream b(std::move(a));
+        REQUIRE( b.data() == data );
+        REQUIRE( b.size() == 5 );
+        REQUIRE( a.output_ready() == false );
+        REQUIRE( a.input_ready() == false );
+        REQUIRE( a.data() == NULL );
+
+        // the modes are moved and the default sink follows the output
+        b << "%d2[2]";
+        REQUIRE( b.size() == 7 );
+        REQUIRE( b[5] == 0 );
+        REQUIRE( b[6] == 2 );
+
+        BinStream c;
+        c << "ff";
+        data = b.data();
+        c = std::move(b);
+        REQUIRE( c.data() == data );
+        REQUIRE( c.size() == 7 );
+        REQUIRE( b.size() == 0 );
+        c << "300";
+        REQUIRE( c.size() == 9 );
+        REQUIRE( c[7] == 0x01 );
+
+        // a moved-from instance can be used again
+        b << "%xff";
+        REQUIRE( b.size() == 1 );
+    }
+
+    SECTION( "- the output is taken without copy" )
+    {
+        BinStream b;
+        b << "00112233 'abc'";
+        const char *data = b.data();
+        REQUIRE( data != NULL );
+        REQUIRE( string(data + 4, 3) == "abc" );
+
+        vector<char> output = b.take_output();
+        REQUIRE( output.data() == data );
+        REQUIRE( output.size() == 7 );
+        REQUIRE( b.output_ready() == false );
+        REQUIRE( b.size() == 0 );
+        REQUIRE( b.take_output().empty() );
+
+        b << "44";
+        REQUIRE( b.size() == 1 );
+    }
+}
+
+TEST_CASE( "Check output to an ostream", "[binstream]" )
+{
+    BinStream b;
+    ostringstream out;
+
+    out << b;
+    REQUIRE( out.str().empty() );
+
+    b << "00 ff 'abc' 00";
+    out << b;
+    REQUIRE( out.str() == string("\x00\xff" "abc\x00", 6) );
+}
+
+TEST_CASE( "Check the number of errors", "[binstream]" )
+{
+    BinStream b;
+    b << "00 zz %x1g 'ok'";
+    REQUIRE( b.errors() == 2 );
+    REQUIRE( b.size() == 3 );
+    b << "size[3]";
+    REQUIRE( b.errors() == 3 );
+    b.reset();
+    REQUIRE( b.errors() == 0 );
+    b << "%q12";
+    REQUIRE( b.errors() == 1 );
+}
+
+TEST_CASE( "Check parallel conversion", "[binstream]" )
+{
+    const char *elements[] = {
+        "00", "%xff", "0102", "%d-300", "%f1.5[8]", "'string'", "little-endian",
+        "big-endian", "decimal", "hex", "octal", "17", "size[2]", "size[0]",
+        "%b0101[2]", "repeat[3]", "fill[5]"
+    };
+    string desc;
+    unsigned seed = 1;
+
+    for (int line = 0; line < 20000; ++line)
+    {
+        if (line % 10 == 0)
+        {
+            desc += (line % 20 == 0) ? "# comment hex\n" : "'line string decimal'\n";
+        }
+        for (int i = 0; i < 6; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            desc += elements[(seed >> 16) % (sizeof(elements) / sizeof(*elements))];
+            desc += ' ';
+        }
+        desc += '\n';
+        if (line == 10000)
+        {
+            desc += "zz size[3] 00 size[0]\n";
+        }
+    }
+
+    SECTION( "- the output, the modes and the errors are the serial ones" )
+    {
+        BinStream serial;
+        BinStream parallel;
+        serial.proceed_input(desc.data(), desc.size());
+        parallel.proceed_parallel(desc.data(), desc.size(), 4, 4096);
+
+        REQUIRE( parallel.size() == serial.size() );
+        REQUIRE( memcmp(parallel.data(), serial.data(), serial.size()) == 0 );
+        REQUIRE( parallel.errors() == serial.errors() );
+
+        serial << "%d1 1 300";
+        parallel << "%d1 1 300";
+        REQUIRE( parallel.take_output() == serial.take_output() );
+    }
+
+    SECTION( "- labels, references and alignments only in comments and strings" )
+    {
+        string text = desc + "# Header: @x align[4]\n'a:b @c' 01 'pad-to[8]'\n" + desc;
+        BinStream serial;
+        BinStream parallel;
+        serial.proceed_input(text.data(), text.size());
+        parallel.proceed_parallel(text.data(), text.size(), 4, 4096);
+
+        REQUIRE( parallel.take_output() == serial.take_output() );
+        REQUIRE( parallel.errors() == serial.errors() );
+    }
+
+    SECTION( "- labels, references and alignments need the whole output" )
+    {
+        string text = desc + ":here 01 align[4] 02\n" + desc + "@here[4] pad-to[8]\n";
+        BinStream serial;
+        BinStream parallel;
+        serial.proceed_input(text.data(), text.size());
+        serial.check_references();
+        parallel.proceed_parallel(text.data(), text.size(), 4, 4096);
+        parallel.check_references();
+
+        REQUIRE( parallel.take_output() == serial.take_output() );
+        REQUIRE( parallel.errors() == serial.errors() );
+    }
+
+    SECTION( "- an exception stops the output where the serial one does" )
+    {
+        string bad = desc + "size[0] decimal 99999999999999999999999\n" + desc;
+        BinStream serial;
+        BinStream parallel;
+        REQUIRE_THROWS_AS( serial.proceed_input(bad.data(), bad.size()),
+                const std::out_of_range & );
+        REQUIRE_THROWS_AS( parallel.proceed_parallel(bad.data(), bad.size(), 4, 4096),
+                const std::out_of_range & );
+        REQUIRE( parallel.take_output() == serial.take_output() );
+    }
+
+    SECTION( "- a small input is converted on the calling thread" )
+    {
+        BinStream b;
+        b.proceed_parallel("00 11", 5, 4);
+        REQUIRE( b.size() == 2 );
+    }
+}
+
+TEST_CASE( "Check repeat and fill directives", "[binstream]" )
+{
+    SECTION( "- the output is the one of the expanded description" )
+    {
+        BinStream b;
+        b << "repeat[3] 0102 repeat[2] 'ab' big-endian repeat[2] %d300[4] fill[3]";
+        REQUIRE( b.take_output() == vector<char>({2, 1, 2, 1, 2, 1, 'a', 'b', 'a', 'b',
+                0, 0, 1, 44, 0, 0, 1, 44, 0, 0, 0}) );
+
+        // a repeat waits for the next value, even on the next line
+        b << "repeat[2] hex size[2]\n'a b'\nrepeat[0] 01 repeat[2] fill[2] 03";
+        REQUIRE( b.take_output() == vector<char>({'a', ' ', 'b', 'a', ' ', 'b', 0, 0, 0, 0, 0, 3}) );
+
+        // a value in error consumes the repeat
+        b << "size[0] repeat[4] zz 05";
+        REQUIRE( b.take_output() == vector<char>({5}) );
+        REQUIRE( b.errors() == 1 );
+    }
+
+    SECTION( "- a bad count is not a directive" )
+    {
+        BinStream b;
+        REQUIRE( b.update_internal_state("repeat[2]") );
+        REQUIRE( b.update_internal_state("fill[0]") );
+        REQUIRE( b.update_internal_state("repeat[]") == false );
+        REQUIRE( b.update_internal_state("fill[x]") == false );
+        REQUIRE( b.update_internal_state("repeat[2]x") == false );
+    }
+
+    SECTION( "- an overflowing size or a pending repeat is reported" )
+    {
+        BinStream b;
+        b << "01 repeat[9223372036854775808] 'ab' 02";
+        REQUIRE( b.errors() == 1 );
+        REQUIRE( b.take_output() == vector<char>({1, 2}) );
+
+        b << "repeat[4294967296] fill[4294967296] 03";
+        REQUIRE( b.errors() == 2 );
+        REQUIRE( b.take_output() == vector<char>({3}) );
+        b.check_references();
+
+        b << "04 repeat[2]";
+        REQUIRE_THROWS_AS( b.check_references(), const BSExceptionPendingRepeat & );
+
+        char buffer[4];
+        FixedBufferSink sink(buffer, sizeof(buffer));
+        REQUIRE_THROWS_AS( sink.fill("ab", 2, 1ULL << 63), const BSExceptionFillTooLarge & );
+        REQUIRE( sink.size() == 0 );
+    }
+
+    SECTION( "- a large fill is written without expanding it" )
+    {
+        BinStream b;
+        REQUIRE( b.measure("fill[1099511627776] repeat[1000000000] 'abc'") ==
+                (1ULL << 40) + 3000000000ULL );
+
+        b << "01 fill[268435456] repeat[1048576] 'abcd' 02";
+        REQUIRE( b.size() == 2 + (256 << 20) + (4 << 20) );
+        REQUIRE( b[0] == 1 );
+        REQUIRE( b[1 + (256 << 20) - 1] == 0 );
+        REQUIRE( memcmp(b.data() + b.size() - 5, "abcd\x02", 5) == 0 );
+    }
+
+    SECTION( "- a pending repeat is carried across the chunks of a parallel conversion" )
+    {
+        string desc;
+        for (int line = 0; line < 5000; ++line)
+        {
+            desc += (line % 7 == 0) ? "repeat[3]\n" : "01 'ab' fill[2] repeat[2]\n";
+        }
+        BinStream serial;
+        BinStream parallel;
+        serial.proceed_input(desc.data(), desc.size());
+        parallel.proceed_parallel(desc.data(), desc.size(), 4, 4096);
+        REQUIRE( parallel.take_output() == serial.take_output() );
+    }
+}
+
+TEST_CASE( "Check LEB128 numbers", "[binstream]" )
+{
+    SECTION( "- LEB128 numbers are written in their smallest or padded encoding" )
+    {
+        BinStream b;
+        b << "big-endian %u624485 %s-123456 %u1[3] repeat[2] %s-1 size[4] %u0";
+        REQUIRE( b.errors() == 0 );
+        REQUIRE( b.take_output() == vector<char>({(char)0xe5, (char)0x8e, 0x26,
+                (char)0xc0, (char)0xbb, 0x78, (char)0x81, (char)0x80, 0, 0x7f, 0x7f, 0}) );
+
+        b << "%u128[1] %s1x %u-1 01";
+        REQUIRE( b.errors() == 3 );
+        REQUIRE( b.take_output() == vector<char>({0, 0, 0, 1}) );
+    }
+
+    SECTION( "- many LEB128 numbers are encoded in place" )
+    {
+        vector<uint64_t> values;
+        string desc;
+        for (uint64_t i = 0; i < 2000; ++i)
+        {
+            values.push_back(i * i * i);
+            desc += "%u" + to_string(i * i * i) + " ";
+        }
+        BinStream text;
+        BinStream batch;
+        text << desc;
+        batch.emit_leb128s(values.data(), values.size(), false);
+        REQUIRE( batch.position() == text.position() );
+        REQUIRE( batch.take_output() == text.take_output() );
+
+        // the room for the largest encodings does not fit a small buffer
+        char buffer[8];
+        FixedBufferSink sink(buffer, sizeof(buffer));
+        batch.set_sink(&sink);
+        batch.emit_leb128s(values.data(), 5, true);
+        REQUIRE( sink.size() == 6 );
+        REQUIRE( memcmp(buffer, "\x00\x01\x08\x1b\xc0\x00", 6) == 0 );
+    }
+}
+
+TEST_CASE( "Check alignment and padding directives", "[binstream]" )
+{
+    SECTION( "- the gaps are filled up to the alignments and the offsets" )
+    {
+        BinStream b;
+        b << "01 align[4] 02 03 align[4,ff] 04 pad-to[10] 05 pad-to[12,aa] align[1] align[4]";
+        REQUIRE( b.errors() == 0 );
+        REQUIRE( b.take_output() == vector<char>({1, 0, 0, 0, 2, 3, (char)0xff, (char)0xff,
+                4, 0, 5, (char)0xaa}) );
+
+        // the offsets start at the output reset, a directive cannot be repeated
+        b << "repeat[3] align[4] 01 align[3,F] 02 pad-to[4] repeat[2] pad-to[8] 03";
+        REQUIRE( b.errors() == 2 );
+        REQUIRE( b.take_output() == vector<char>({1, 0x0f, 0x0f, 2, 3}) );
+        REQUIRE( b.measure("01 align[4096] pad-to[8192,ff] align[3]") == 8193 );
+    }
+
+    SECTION( "- bad alignments and offsets" )
+    {
+        BinStream b;
+        b << "fill[5] pad-to[3] align[0] 01";
+        REQUIRE( b.errors() == 2 );
+        REQUIRE( b.size() == 6 );
+        REQUIRE( b.update_internal_state("align[8,F]") );
+        REQUIRE( b.update_internal_state("align[8,fff]") == false );
+        REQUIRE( b.update_internal_state("align[8,]") == false );
+        REQUIRE( b.update_internal_state("align[,ff]") == false );
+        REQUIRE( b.update_internal_state("pad-to[x]") == false );
+        REQUIRE( b.update_internal_state("pad-to[8") == false );
+        REQUIRE( b.update_internal_state("pad-to[8]]") == false );
+        REQUIRE( b.update_internal_state("align[8,ff]x") == false );
+    }
+
+    SECTION( "- the streaming and the parallel conversions need no look-back" )
+    {
+        string desc;
+        for (int line = 0; line < 5000; ++line)
+        {
+            desc += (line % 7 == 0) ? "align[64,ee]\n" : "01 'ab' align[3] 02\n";
+        }
+        desc += "pad-to[200000,ff]";
+        BinStream serial;
+        BinStream parallel;
+        BinStream streamed;
+        vector<char> output;
+        VectorSink sink(output);
+        istringstream in(desc);
+        serial.proceed_input(desc.data(), desc.size());
+        parallel.proceed_parallel(desc.data(), desc.size(), 4, 4096);
+        streamed.stream(in, sink, 64);
+        vector<char> expected = serial.take_output();
+        REQUIRE( expected.size() == 200000 );
+        REQUIRE( parallel.take_output() == expected );
+        REQUIRE( output == expected );
+    }
+}
+
+TEST_CASE( "Check labels and references", "[binstream]" )
+{
+    const char *desc = "'HDR'\nbig-endian @data[4] @end-data[2] @end\n:data\n"
+            "01 02 03\nrepeat[2] 'ab'\n:end\n@data-end[1] @end[2] repeat[2] @data[1]";
+    const vector<char> expected({'H', 'D', 'R', 0, 0, 0, 13, 0, 7, 0, 0, 0, 20,
+            1, 2, 3, 'a', 'b', 'a', 'b', (char)0xf9, 0, 20, 13, 13});
+
+    SECTION( "- backward and forward references give the offsets and distances" )
+    {
+        BinStream b;
+        b << desc;
+        REQUIRE( b.unresolved() == 0 );
+        REQUIRE( b.errors() == 0 );
+        REQUIRE( b.position() == expected.size() );
+        REQUIRE( b.take_output() == expected );
+        REQUIRE( b.position() == 0 );
+
+        // the default size is the current size, else 4 bytes
+        b << "size[2] 00 :a @a size[0] @a";
+        REQUIRE( b.take_output() == vector<char>({0, 0, 0, 2, 0, 0, 0, 2}) );
+    }
+
+    SECTION( "- many forward references are patched as their labels are defined" )
+    {
+        string desc = ":m\n";
+        vector<char> expected;
+        for (uint32_t i = 0; i < 50000; ++i)
+        {
+            desc += "@l" + to_string(49999 - i) + "-m[4] @m-l" + to_string(i) + "[4]\n";
+            for (uint32_t value : {400000 + 49999 - i, 0 - (400000 + i)})
+            {
+                for (int k = 0; k < 4; ++k)
+                {
+                    expected.push_back((char)(value >> (8 * k)));
+                }
+            }
+        }
+        for (int i = 0; i < 50000; ++i)
+        {
+            desc += ":l" + to_string(i) + " 01\n";
+        }
+        expected.insert(expected.end(), 50000, 1);
+        BinStream b;
+        b << desc;
+        REQUIRE( b.unresolved() == 0 );
+        REQUIRE( b.errors() == 0 );
+        REQUIRE( b.take_output() == expected );
+    }
+
+    SECTION( "- the references are patched in the sink and the parallel conversion is serial" )
+    {
+        string big;
+        for (int i = 0; i < 100000; ++i)
+        {
+            big += "00 11 22 33\n";
+        }
+        string labeled = string("@end ") + big + ":end\n" + big;
+        BinStream serial;
+        BinStream parallel;
+        char path[] = "/tmp/binmake_testXXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE( fd >= 0 );
+        {
+            FdSink sink(fd, 1024);
+            BinStream b;
+            b.set_sink(&sink);
+            b << labeled;
+        }
+        serial.proceed_input(labeled.data(), labeled.size());
+        parallel.proceed_parallel(labeled.data(), labeled.size(), 4, 4096);
+        REQUIRE( parallel.take_output() == serial.take_output() );
+
+        char head[4];
+        REQUIRE( pread(fd, head, 4, 0) == 4 );
+        REQUIRE( memcmp(head, "\x84\x1a\x06\x00", 4) == 0 );
+        close(fd);
+        unlink(path);
+    }
+
+    SECTION( "- the measure and the compilation do not need the labels defined" )
+    {
+        BinStream b;
+        REQUIRE( b.measure(desc) == expected.size() );
+        REQUIRE( b.measure("@undefined[2] @a-b") == 6 );
+        Program program = b.compile(desc);
+        vector<char> output;
+        VectorSink sink(output);
+        program.run(sink);
+        REQUIRE( output == expected );
+    }
+
+    SECTION( "- bad labels and references are errors" )
+    {
+        BinStream b;
+        b << "@undefined[2] :a 00 :a";
+        REQUIRE( b.errors() == 1 );
+        REQUIRE( b.unresolved() == 1 );
+        REQUIRE_THROWS_AS( b.check_references(), const BSExceptionUnresolvedLabel & );
+        b.reset();
+
+        b << "@a[3] @a[1]x @ @a- :a-b : fill[300] :a @a[1] %d-1[1]";
+        REQUIRE( b.errors() == 7 );
+        REQUIRE( b.size() == 302 );
+        REQUIRE( b[300] == 0 );
+        b.reset();
+
+        // a forward reference cannot be repeated
+        b << "repeat[2] @a[1] repeat[0] @a :a";
+        REQUIRE( b.errors() == 1 );
+        REQUIRE( b.take_output() == vector<char>({0, 0}) );
+        REQUIRE( b.unresolved() == 0 );
+        b.check_references();
+
+        // a distance which does not fit
+        b << ":a fill[200] :b @a-b[1] @b-a[1] @a-b[2]";
+        REQUIRE( b.errors() == 2 );
+        REQUIRE( b.size() == 204 );
+        REQUIRE( b[200] == 0 );
+        REQUIRE( (unsigned char)b[201] == 200 );
+        REQUIRE( (unsigned char)b[202] == 0x38 );
+        REQUIRE( (unsigned char)b[203] == 0xff );
+    }
+}
+
+TEST_CASE( "Check checksums", "[binstream]" )
+{
+    SECTION( "- a checksum after its labels is written at once" )
+    {
+        BinStream b;
+        b << "'HDR'\n:s 'hello' 01 02 fill[1000] repeat[3] 'ab' :e\n"
+                "big-endian crc32[s:e] crc32c[s:e] adler32[s:e] little-endian crc32[s:e]";
+        REQUIRE( b.errors() == 0 );
+        REQUIRE( b.unresolved() == 0 );
+        vector<char> output = b.take_output();
+        REQUIRE( output.size() == 3 + 1013 + 16 );
+        const char *range = output.data() + 3;
+        uint32_t crc = crc32(0, range, 1013);
+        uint32_t crcc = crc32c(0, range, 1013);
+        uint32_t adler = adler32(1, range, 1013);
+        const char expected[] = {
+            (char)(crc >> 24), (char)(crc >> 16), (char)(crc >> 8), (char)crc,
+            (char)(crcc >> 24), (char)(crcc >> 16), (char)(crcc >> 8), (char)crcc,
+            (char)(adler >> 24), (char)(adler >> 16), (char)(adler >> 8), (char)adler,
+            (char)crc, (char)(crc >> 8), (char)(crc >> 16), (char)(crc >> 24)};
+        REQUIRE( memcmp(range + 1013, expected, 16) == 0 );
+    }
+
+    SECTION( "- a checksum waits for its labels and the placeholders between them" )
+    {
+        // the header covers a forward reference and a forward checksum
+        const char *desc = "crc32[s:end] adler32[s:end]\n:s @end crc32c[a:b] 'x'\n"
+                ":a 'payload' %d300[2] :b fill[50] :end";
+        BinStream b;
+        b << desc;
+        REQUIRE( b.errors() == 0 );
+        REQUIRE( b.unresolved() == 0 );
+        b.check_references();
+        vector<char> output = b.take_output();
+        REQUIRE( output.size() == 8 + 9 + 9 + 50 );
+        uint32_t value;
+        memcpy(&value, output.data() + 12, 4);
+        REQUIRE( value == crc32c(0, output.data() + 17, 9) );
+        memcpy(&value, output.data() + 8, 4);
+        REQUIRE( value == output.size() );
+        memcpy(&value, output.data(), 4);
+        REQUIRE( value == crc32(0, output.data() + 8, output.size() - 8) );
+        memcpy(&value, output.data() + 4, 4);
+        REQUIRE( value == adler32(1, output.data() + 8, output.size() - 8) );
+
+        // same output through a file descriptor with a small buffer
+        char path[] = "/tmp/binmake_testXXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE( fd >= 0 );
+        {
+            FdSink sink(fd, 16);
+            BinStream f;
+            f.set_sink(&sink);
+            f << desc;
+            REQUIRE( f.unresolved() == 0 );
+        }
+        vector<char> written(output.size());
+        REQUIRE( pread(fd, written.data(), written.size(), 0) == (ssize_t)written.size() );
+        REQUIRE( written == output );
+        close(fd);
+        unlink(path);
+    }
+
+    SECTION( "- many checksums wait for the placeholders between their labels" )
+    {
+        string desc;
+        for (int i = 0; i < 20000; ++i)
+        {
+            desc += ":s" + to_string(i) + " @x" + to_string(i) + "[4] 'ab' :e" +
+                    to_string(i) + " crc32[s" + to_string(i) + ":e" + to_string(i) + "]\n";
+        }
+        for (int i = 0; i < 20000; ++i)
+        {
+            desc += ":x" + to_string(i) + " 01\n";
+        }
+        BinStream b;
+        b << desc;
+        REQUIRE( b.errors() == 0 );
+        REQUIRE( b.unresolved() == 0 );
+        vector<char> output = b.take_output();
+        REQUIRE( output.size() == 20000 * 10 + 20000 );
+        size_t bad = 0;
+        for (uint32_t i = 0; i < 20000; ++i)
+        {
+            const char *block = output.data() + 10 * i;
+            uint32_t offset;
+            uint32_t value;
+            memcpy(&offset, block, 4);
+            memcpy(&value, block + 6, 4);
+            bad += (offset != 200000 + i) || (value != crc32(0, block, 6));
+        }
+        REQUIRE( bad == 0 );
+    }
+
+    SECTION( "- a checksum covering its own bytes counts them as zeros" )
+    {
+        BinStream b;
+        b << ":a 'ab' crc32[a:b] :b";
+        vector<char> output = b.take_output();
+        uint32_t value;
+        memcpy(&value, output.data() + 2, 4);
+        REQUIRE( value == crc32(0, "ab\0\0\0\0", 6) );
+    }
+
+    SECTION( "- bad and unresolved checksums" )
+    {
+        BinStream b;
+        b << "crc32[a] crc32[a:] crc32[a:b]x md5[a:b] :b 00 :a crc32[a:b] 'x'";
+        REQUIRE( b.errors() == 5 );
+        REQUIRE( b.size() == 6 );
+        b.reset();
+
+        // a checksum not computed yet cannot be repeated
+        b << "repeat[2] crc32[a:b] :a :b repeat[2] adler32[a:b]";
+        REQUIRE( b.errors() == 1 );
+        REQUIRE( b.take_output() == vector<char>({0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 1, 0, 0, 0}) );
+        b.reset();
+
+        b << "crc32[a:b] :a 00";
+        REQUIRE_THROWS_AS( b.check_references(), const BSExceptionUnresolvedLabel & );
+        b.reset();
+
+        // two checksums covering each other
+        b << ":a crc32[c:d] :b :c crc32[a:b] :d";
+        REQUIRE( b.unresolved() == 2 );
+        REQUIRE_THROWS_AS( b.check_references(), const BSExceptionUnresolvedChecksum & );
+    }
+}
@@ -0,0 +1,94 @@
+#include <string>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "bin_cache.h"
+
+using namespace std;
+using namespace BS;
+
+TEST_CASE("Unit Tests of the binary cache")
+{
+    SECTION("Unit test of 'hash128()'")
+    {
+        uint64_t h1[2];
+        uint64_t h2[2];
+        string data("big-endian 00112233 'some text long enough to hash blocks'");
+
+        hash128(data.data(), data.size(), 0, h1);
+        hash128(data.data(), data.size(), 0, h2);
+        REQUIRE( h1[0] == h2[0] );
+        REQUIRE( h1[1] == h2[1] );
+        for (size_t size = 0; size < data.size(); ++size)
+        {
+            hash128(data.data(), size, 0, h2);
+            REQUIRE( ((h1[0] != h2[0]) || (h1[1] != h2[1])) );
+        }
+        hash128(data.data(), data.size(), 1, h2);
+        REQUIRE( ((h1[0] != h2[0]) || (h1[1] != h2[1])) );
+    }
+
+    SECTION("Unit test of 'BinCache'")
+    {
+        char dir[] = "/tmp/binmake_cacheXXXXXX";
+        REQUIRE( mkdtemp(dir) != NULL );
+        BinCache cache(dir, "v1");
+        string entry = cache.entry("00 11", 5);
+        string output = string(dir) + "/output.bin";
+        char buffer[8];
+
+        REQUIRE( cache.usable() );
+        REQUIRE( entry != cache.entry("00 12", 5) );
+        REQUIRE( entry != BinCache(dir, "v2").entry("00 11", 5) );
+        REQUIRE( cache.contains(entry) == false );
+
+        string temp_path = cache.temp_path(entry);
+        int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT, 0666);
+        REQUIRE( write(fd, "\x00\x11", 2) == 2 );
+        close(fd);
+        REQUIRE( cache.publish(temp_path, entry) );
+        REQUIRE( cache.contains(entry) );
+
+        REQUIRE( cache.fetch(entry, output) );
+        fd = open(output.c_str(), O_RDONLY);
+        REQUIRE( read(fd, buffer, sizeof(buffer)) == 2 );
+        REQUIRE( buffer[1] == 0x11 );
+        close(fd);
+
+        // the output already written is kept
+        fd = open(output.c_str(), O_WRONLY | O_TRUNC);
+        REQUIRE( write(fd, "hdr", 3) == 3 );
+        REQUIRE( copy_file(entry, fd) );
+        close(fd);
+        fd = open(output.c_str(), O_RDONLY);
+        REQUIRE( read(fd, buffer, sizeof(buffer)) == 5 );
+        REQUIRE( string(buffer, 5) == string("hdr\x00\x11", 5) );
+        close(fd);
+
+        unlink(output.c_str());
+        unlink(entry.c_str());
+        rmdir(dir);
+    }
+
+    SECTION("Unit test of 'BinCache::usable()'")
+    {
+        char dir[] = "/tmp/binmake_cacheXXXXXX";
+        REQUIRE( mkdtemp(dir) != NULL );
+        string file = string(dir) + "/file";
+        int fd = open(file.c_str(), O_WRONLY | O_CREAT, 0666);
+        close(fd);
+
+        // a missing directory is created
+        REQUIRE( BinCache(string(dir) + "/cache", "v1").usable() );
+        REQUIRE( rmdir((string(dir) + "/cache").c_str()) == 0 );
+        // a directory that can not be created or written is not usable
+        REQUIRE_FALSE( BinCache(file + "/cache", "v1").usable() );
+        REQUIRE_FALSE( BinCache(file, "v1").usable() );
+        REQUIRE_FALSE( BinCache("/nonexistent/binmake/cache", "v1").usable() );
+
+        unlink(file.c_str());
+        rmdir(dir);
+    }
+}
@@ -1,5 +1,10 @@
+#include <cmath>
+#include <cstring>
 #include <string>
 #include <vector>
+#include <random>
+#include <regex>
+#include <stdexcept>
 
 #include "catch.hpp"
 #include "bs_data.h"
@@ -204,6 +209,7 @@ TEST_CASE("Unit Tests of bin_tools functions")
         number.is_set = true;
         number.size = 4;
         number.num_signed = false;
+        number.num_float = false;
         number.value_u64 = 0x00112233;
 
         // little-endian
@@ -244,6 +250,173 @@ TEST_CASE("Unit Tests of bin_tools functions")
         REQUIRE( v.data()[3] == 0x19 );
    }
 
+    SECTION("Unit test of 'decode_hex_bytes()'")
+    {
+        char out[64];
+        size_t count;
+        string line;
+
+        REQUIRE( decode_hex_bytes("0a Ff\t 10", 9, out, count) );
+        REQUIRE( count == 3 );
+        REQUIRE( string(out, count) == "\x0a\xff\x10" );
+
+        for (int i = 0; i < 40; ++i)
+        {
+            line += "5a ";
+        }
+        line += "01";
+        REQUIRE( decode_hex_bytes(line.data(), line.size(), out, count) );
+        REQUIRE( count == 41 );
+        REQUIRE( string(out, count) == string(40, 'Z') + "\x01" );
+
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            if (line[i] == ' ')
+            {
+                continue;
+            }
+            string bad(line);
+            bad[i] = 'g';
+            REQUIRE( decode_hex_bytes(bad.data(), bad.size(), out, count) == false );
+            bad[i] = (char)0xe9;
+            REQUIRE( decode_hex_bytes(bad.data(), bad.size(), out, count) == false );
+        }
+        REQUIRE( decode_hex_bytes("0a1", 3, out, count) == false );
+        REQUIRE( decode_hex_bytes("0a 1", 4, out, count) == false );
+        REQUIRE( decode_hex_bytes("%x0a", 4, out, count) == false );
+    }
+
+    SECTION("Unit test of 'add_numbers_to_vector_char()' and 'add_numbers_to_sink()'")
+    {
+        const uint64_t values[] = {0x0102030405060708UL, 0x1112131415161718UL};
+        const int sizes[] = {1, 2, 4, 8};
+        vector<char> v;
+        vector<char> expected;
+        number_t number;
+        number.is_set = true;
+        number.num_signed = false;
+        number.num_float = false;
+
+        for (int size: sizes)
+        {
+            for (endianess_t endian: {little_endian, big_endian})
+            {
+                number.size = size;
+                number.endianess = endian;
+                expected.assign(1, 'x');
+                for (uint64_t value: values)
+                {
+                    number.value_u64 = value;
+                    add_number_to_vector_char(expected, number);
+                }
+
+                v.assign(1, 'x');
+                add_numbers_to_vector_char(v, values, 2, size, endian);
+                REQUIRE( v == expected );
+
+                v.assign(1, 'x');
+                VectorSink sink(v);
+                add_numbers_to_sink(sink, values, 2, size, endian);
+                REQUIRE( v == expected );
+            }
+        }
+
+        v.clear();
+        add_numbers_to_vector_char(v, values, 2, 2, big_endian);
+        REQUIRE( v == vector<char>({0x07, 0x08, 0x17, 0x18}) );
+
+        // more values than a single batch
+        vector<uint64_t> many(5000);
+        for (size_t i = 0; i < many.size(); ++i)
+        {
+            many[i] = i;
+        }
+        v.clear();
+        VectorSink sink(v);
+        add_numbers_to_sink(sink, many.data(), many.size(), 4, little_endian);
+        REQUIRE( v.size() == 4 * many.size() );
+        REQUIRE( v[4 * 4999] == (char)(4999 & 0xFF) );
+        REQUIRE( v[4 * 4999 + 1] == (char)(4999 >> 8) );
+    }
+
+    SECTION("Unit test of the LEB128 encoders")
+    {
+        char out[MAX_LEB128_SIZE];
+        size_t count;
+
+        const struct { uint64_t value; const char *bytes; size_t size; } unsigned_cases[] = {
+            {0, "\x00", 1}, {127, "\x7f", 1}, {128, "\x80\x01", 2},
+            {624485, "\xe5\x8e\x26", 3},
+            {UINT64_MAX, "\xff\xff\xff\xff\xff\xff\xff\xff\xff\x01", 10}};
+        for (const auto & c : unsigned_cases)
+        {
+            REQUIRE( encode_uleb128(c.value, out) == c.size );
+            REQUIRE( memcmp(out, c.bytes, c.size) == 0 );
+        }
+        const struct { int64_t value; const char *bytes; size_t size; } signed_cases[] = {
+            {0, "\x00", 1}, {63, "\x3f", 1}, {64, "\xc0\x00", 2}, {-1, "\x7f", 1},
+            {-64, "\x40", 1}, {-65, "\xbf\x7f", 2}, {-123456, "\xc0\xbb\x78", 3},
+            {INT64_MIN, "\x80\x80\x80\x80\x80\x80\x80\x80\x80\x7f", 10}};
+        for (const auto & c : signed_cases)
+        {
+            REQUIRE( encode_sleb128(c.value, out) == c.size );
+            REQUIRE( memcmp(out, c.bytes, c.size) == 0 );
+        }
+
+        // padded to a size with continuation bytes
+        REQUIRE( encode_uleb128(1, out, 3) == 3 );
+        REQUIRE( memcmp(out, "\x81\x80\x00", 3) == 0 );
+        REQUIRE( encode_sleb128(-1, out, 3) == 3 );
+        REQUIRE( memcmp(out, "\xff\xff\x7f", 3) == 0 );
+        REQUIRE( encode_uleb128(128, out, 1) == 0 );
+        REQUIRE( encode_sleb128(64, out, 1) == 0 );
+        REQUIRE( encode_uleb128(1, out, 11) == 0 );
+
+        // the batch encoder writes the same bytes as the single one
+        mt19937_64 rng(25);
+        vector<uint64_t> values(3000);
+        for (size_t i = 0; i < values.size(); ++i)
+        {
+            values[i] = rng() >> (rng() % 64);
+            values[i] = (i % 3 == 0) ? 0 - values[i] : values[i];
+        }
+        for (bool is_signed : {false, true})
+        {
+            vector<char> batch(values.size() * MAX_LEB128_SIZE);
+            vector<char> single;
+            for (uint64_t value : values)
+            {
+                count = is_signed ? encode_sleb128((int64_t)value, out) : encode_uleb128(value, out);
+                single.insert(single.end(), out, out + count);
+            }
+            batch.resize(encode_leb128s(values.data(), values.size(), is_signed, batch.data()));
+            REQUIRE( batch == single );
+        }
+    }
+
+    SECTION("Unit test of 'extract_leb128()'")
+    {
+        char out[MAX_LEB128_SIZE];
+        size_t count;
+
+        REQUIRE( extract_leb128("%u624485", 8, t_num_uleb128, out, count) );
+        REQUIRE( count == 3 );
+        REQUIRE( extract_leb128("%s-123456", 9, t_num_sleb128, out, count) );
+        REQUIRE( memcmp(out, "\xc0\xbb\x78", 3) == 0 );
+        REQUIRE( extract_leb128("%s+5[2]", 7, t_num_sleb128, out, count) );
+        REQUIRE( memcmp(out, "\x85\x00", count) == 0 );
+        REQUIRE( extract_leb128("%u128[1]", 8, t_num_uleb128, out, count) == false );
+        REQUIRE( extract_leb128("%u-1", 4, t_num_uleb128, out, count) == false );
+        REQUIRE( extract_leb128("%u1x", 4, t_num_uleb128, out, count) == false );
+        REQUIRE_THROWS_AS( extract_leb128("%u18446744073709551616", 22, t_num_uleb128, out, count),
+                const std::out_of_range & );
+        REQUIRE_THROWS_AS( extract_leb128("%s9223372036854775808", 21, t_num_sleb128, out, count),
+                const std::out_of_range & );
+        REQUIRE( get_type("%u1") == t_num_uleb128 );
+        REQUIRE( get_type("%s-1") == t_num_sleb128 );
+        REQUIRE( check_grammar("%s-1[4]", t_num_sleb128) );
+    }
+
     SECTION("Unit test of 'extract_endianess()'")
     {
         endianess_t endian;
@@ -330,6 +503,39 @@ TEST_CASE("Unit Tests of bin_tools functions")
         REQUIRE( get_state_type("deci", state) == false );
     }
 
+    SECTION("Unit test of 'lex_state()'")
+    {
+        const char *keywords[] = {
+            "little-endian", "big-endian", "hexadecimal", "hexa", "hex",
+            "decimal", "dec", "float", "octal", "oct", "binary", "bin"
+        };
+        const char *others[] = {
+            "", "h", "he", "hexb", "Hex", "hexadecimals", "little-endiaN",
+            "big_endian", "floa", "floats", "octa", "bi", "binarY", "decimals",
+            "ffffffffff", "0123456", "size[]", "siz[4]", "size4"
+        };
+        state_token_t tok;
+
+        for (const char *keyword : keywords)
+        {
+            INFO( "keyword '" << keyword << "'" );
+            REQUIRE( lex_state(keyword, strlen(keyword), tok) );
+            REQUIRE( tok.type != t_state_type_size );
+        }
+        for (const char *other : others)
+        {
+            INFO( "element '" << other << "'" );
+            REQUIRE( lex_state(other, strlen(other), tok) == false );
+        }
+        REQUIRE( lex_state(" oct ", 5, tok) );
+        REQUIRE( tok.num_type == t_num_octal );
+        REQUIRE( lex_state("big-endian", 10, tok) );
+        REQUIRE( tok.endianess == big_endian );
+        REQUIRE( lex_state("xsize[16]", 9, tok) );
+        REQUIRE( tok.type == t_state_type_size );
+        REQUIRE( tok.size == 16 );
+    }
+
     SECTION("Unit test of 'extract_size()'")
     {
         int size;
@@ -355,3 +561,214 @@ TEST_CASE("Unit Tests of bin_tools functions")
         REQUIRE( extract_size("size1", size) == false);
     }
 }
+
+TEST_CASE("Lexer accepts the same grammar as the regular expressions")
+{
+    const char *elements[] = {
+        "", "0", "00", "ff", "%xff", "%x", "%xg", "%x0a3[4]", "%x0a3[]",
+        "%x0a3[4", "%x0a3[4]]", "a3[12]", "%d42", "%d+42", "%d-42", "%d-",
+        "-023", "+", "42[4]", "4 2", "%f1", "%f1.", "%f1.5", "%f.5",
+        "%f1.5e3", "%f1.5e", "%f1e+3", "%f1e+", "%f-2.e8[4]", "%f5.145E-3",
+        "%f1a.2", "%o017", "%o09", "%b0101", "%b012", "%b[1]", "1101[8]x",
+        "%d12%d", "size[4]", "[4]"
+    };
+    struct
+    {
+        type_t type;
+        const char *pattern;
+    } grammars[] = {
+        {t_num_hexadecimal, R"((%x)?[\da-fA-F]+(\[\d+\])?)"},
+        {t_num_decimal, R"((%d)?[+-]?\d+(\[\d+\])?)"},
+        {t_num_float, R"((%f)?[+-]?\d+\.?\d*([eE][+-]?\d+)?(\[\d+\])?)"},
+        {t_num_octal, R"((%o)?[0-7]+(\[\d+\])?)"},
+        {t_num_binary, R"((%b)?[01]+(\[\d+\])?)"}
+    };
+
+    for (const auto & grammar : grammars)
+    {
+        regex pattern(grammar.pattern);
+        for (const char *element : elements)
+        {
+            INFO( "element '" << element << "', type " << grammar.type );
+            REQUIRE( check_grammar(element, grammar.type) ==
+                    regex_match(element, pattern) );
+        }
+    }
+
+    regex explicit_number(R"(%[fdxbo]{1}\S+)");
+    for (const char *element : elements)
+    {
+        INFO( "element '" << element << "'" );
+        if (element[0] == '%')
+        {
+            REQUIRE( (get_type(element) != t_error) ==
+                    regex_match(element, explicit_number) );
+        }
+    }
+
+    // a size state can be found anywhere in an element
+    int size;
+    REQUIRE( extract_size("resize[4]", size) );
+    REQUIRE( size == 4 );
+    REQUIRE( get_type("resize[4]") == t_internal_state );
+    REQUIRE( get_type(" big-endian ") == t_internal_state );
+}
+
+TEST_CASE("Integer parsers give the same values and sizes as the standard conversions")
+{
+    struct
+    {
+        type_t type;
+        int base;
+        const char *digits;
+    } radixes[] = {
+        {t_num_hexadecimal, 16, "0123456789abcdefABCDEF"},
+        {t_num_decimal, 10, "0123456789"},
+        {t_num_octal, 8, "01234567"},
+        {t_num_binary, 2, "01"}
+    };
+    vector<string> elements = {
+        "18446744073709551615", "18446744073709551616", "99999999999999999999",
+        "-9223372036854775808", "-9223372036854775809", "-128", "-129",
+        "-32768", "-32769", "-2147483648", "-2147483649", "-0", "+255", "256",
+        "65535", "65536", "4294967295", "4294967296", "000000000000000000000001"
+    };
+    mt19937 gen(42);
+
+    for (const auto & radix : radixes)
+    {
+        size_t count = strlen(radix.digits);
+        elements.push_back(string(70, radix.digits[count - 1]));
+        for (int i = 0; i < 2000; ++i)
+        {
+            string element((i % 5 == 0) ? "-" : "");
+            int len = 1 + gen() % 70;
+            for (int j = 0; j < len; ++j)
+            {
+                element += radix.digits[gen() % ((j == 0 && i % 3 == 0) ? 1 : count)];
+            }
+            elements.push_back(element);
+        }
+    }
+
+    for (const auto & radix : radixes)
+    {
+        for (const string & element : elements)
+        {
+            number_t number;
+            bool negative = (element[0] == '-');
+            size_t digits = element.find_first_not_of("+-");
+            int64_t value;
+            int size;
+
+            INFO( "element '" << element << "', base " << radix.base );
+            if (!check_grammar(element, radix.type))
+            {
+                continue;
+            }
+            try
+            {
+                if (negative)
+                {
+                    value = stoll(element, NULL, radix.base);
+                }
+                else
+                {
+                    value = (int64_t)stoull(element, NULL, radix.base);
+                }
+            }
+            catch (const out_of_range &)
+            {
+                REQUIRE_THROWS_AS( extract_number(element, number, radix.type, little_endian),
+                        const out_of_range & );
+                continue;
+            }
+            REQUIRE( extract_number(element, number, radix.type, little_endian) );
+            REQUIRE( number.num_signed == negative );
+            REQUIRE( number.value_i64 == value );
+
+            size_t len = element.size() - digits;
+            if (radix.base == 16 || radix.base == 2)
+            {
+                size_t nb_char = (radix.base == 16) ? 2 : 8;
+                size = (len > 4 * nb_char) ? 8 : (len > 2 * nb_char) ? 4 : (len > nb_char) ? 2 : 1;
+            }
+            else if (negative)
+            {
+                size = (value < INT32_MIN) ? 8 : (value < INT16_MIN) ? 4 : (value < INT8_MIN) ? 2 : 1;
+            }
+            else
+            {
+                uint64_t u = (uint64_t)value;
+                size = (u > UINT32_MAX) ? 8 : (u > UINT16_MAX) ? 4 : (u > UINT8_MAX) ? 2 : 1;
+            }
+            REQUIRE( number.size == size );
+        }
+    }
+}
+
+TEST_CASE("Float parser gives the correctly rounded values")
+{
+    vector<string> elements = {
+        "0", "-0", "0.0", "1.2345", "14.23e-4", "-2.e8", "5.145E-3",
+        "16777216", "16777217", "9007199254740993", "0.1", "3.4028235e38",
+        "1e-40", "1.4e-45", "1e-50", "4.9e-324", "2.2250738585072011e-308",
+        "1.00000000000000000000000000001", "123456789012345678901234567890e-20",
+        "0.000000000000000000000000123", "1e22", "1e23", "1e-22", "1e-23"
+    };
+    mt19937 gen(7);
+
+    for (int i = 0; i < 5000; ++i)
+    {
+        string element((i % 4 == 0) ? "-" : "");
+        int len = 1 + gen() % 20;
+        for (int j = 0; j < len; ++j)
+        {
+            element += (char)('0' + gen() % 10);
+        }
+        if (i % 2 == 0)
+        {
+            element.insert(element.size() - gen() % len, ".");
+        }
+        if (i % 3 == 0)
+        {
+            element += "e" + to_string((int)(gen() % 80) - 40);
+        }
+        elements.push_back(element);
+    }
+
+    for (const string & element : elements)
+    {
+        number_t number;
+
+        INFO( "element '" << element << "'" );
+        REQUIRE( check_grammar(element, t_num_float) );
+
+        float32_t f32 = strtof(element.c_str(), NULL);
+        if (isinf(f32))
+        {
+            REQUIRE_THROWS_AS( extract_number(element, number, t_num_float, little_endian, 4),
+                    const out_of_range & );
+        }
+        else
+        {
+            REQUIRE( extract_number(element, number, t_num_float, little_endian, 4) );
+            REQUIRE( memcmp(&number.value_f32, &f32, sizeof(f32)) == 0 );
+        }
+
+        REQUIRE( extract_number(element, number, t_num_float, little_endian, 8) );
+        float64_t f64 = strtod(element.c_str(), NULL);
+        REQUIRE( memcmp(&number.value_f64, &f64, sizeof(f64)) == 0 );
+    }
+
+    // only an overflow is an error
+    number_t number;
+    REQUIRE_THROWS_AS( extract_number("3.5e38", number, t_num_float, little_endian, 4),
+            const out_of_range & );
+    REQUIRE_THROWS_AS( extract_number("-1e309", number, t_num_float, little_endian, 8),
+            const out_of_range & );
+    REQUIRE( extract_number("1e-40", number, t_num_float, little_endian, 4) );
+    REQUIRE( number.value_f32 > 0 );
+    REQUIRE( extract_number("1e-400", number, t_num_float, little_endian, 8) );
+    REQUIRE( number.value_f64 == 0 );
+}
@@ -0,0 +1,114 @@
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "BinBuilder.h"
+#include "BinStream.h"
+
+using namespace std;
+using namespace BS;
+
+static vector<char> text_output(const string & desc)
+{
+    BinStream b;
+    b << desc;
+    return b.take_output();
+}
+
+TEST_CASE("Unit Tests of the typed builder")
+{
+    SECTION("Unit test of the unsigned numbers")
+    {
+        BinStream b;
+        BinBuilder(b).u8(0x12).u16(0x0011).u32(0x00112233)
+                .u64(0x0011223344556677ULL);
+        REQUIRE( b.take_output() == text_output("12 0011 00112233 0011223344556677") );
+
+        BinBuilder(b).big_endian().u8(0x12).u16(0x0011).u32(0x00112233)
+                .u64(0x0011223344556677ULL);
+        REQUIRE( b.take_output() ==
+                text_output("big-endian 12 0011 00112233 0011223344556677") );
+    }
+
+    SECTION("Unit test of the signed numbers")
+    {
+        BinStream b;
+        BinBuilder(b).i8(-1).i16(-300).i32(-2).i64(numeric_limits<int64_t>::min());
+        REQUIRE( b.take_output() ==
+                text_output("%d-1[1] %d-300[2] %d-2[4] %d-9223372036854775808[8]") );
+
+        BinBuilder(b).big_endian().i8(127).i16(-300).i32(-2).i64(-3);
+        REQUIRE( b.take_output() ==
+                text_output("big-endian %d127[1] %d-300[2] %d-2[4] %d-3[8]") );
+    }
+
+    SECTION("Unit test of the floats")
+    {
+        BinStream b;
+        BinBuilder(b).f32(1.2345f).f64(-1.5).big_endian().f32(1.2345f).f64(1e300);
+        REQUIRE( b.take_output() == text_output(
+                "%f1.2345 %f-1.5[8] big-endian %f1.2345 %f1e300[8]") );
+    }
+
+    SECTION("Unit test of an explicit endianess")
+    {
+        BinStream b;
+        BinBuilder(b).u16(0x0011, big_endian).u32(0x00112233, big_endian)
+                .u64(1, big_endian).i16(-2, big_endian).i32(-2, big_endian)
+                .i64(-2, big_endian).f32(1.5f, big_endian).f64(1.5, big_endian)
+                .u16(0x0011);
+        REQUIRE( b.endianess() == little_endian );
+        REQUIRE( b.take_output() == text_output("big-endian 0011 00112233 "
+                "0000000000000001 %d-2[2] %d-2[4] %d-2[8] %f1.5 %f1.5[8] "
+                "little-endian 0011") );
+    }
+
+    SECTION("Unit test of the bytes and strings")
+    {
+        BinStream b;
+        const char raw[] = {0x00, 0x01, (char)0xff};
+        BinBuilder(b).bytes(raw, sizeof(raw)).str("abc").str(string("de"))
+                .bytes(vector<char>{0x42}).bytes(NULL, 0).str("");
+        REQUIRE( b.take_output() == text_output("00 01 ff\n'abc'\n'de'\n42") );
+    }
+
+    SECTION("Unit test of the repeated bytes")
+    {
+        BinStream b;
+        BinBuilder(b).fill(3).fill(2, 0xff).repeat("ab", 2, 3).repeat("c", 1, 0);
+        REQUIRE( b.take_output() == text_output("fill[3] repeat[2] ff repeat[3] 'ab'") );
+
+        const uint64_t unsigned_values[] = {0, 300, UINT64_MAX};
+        const int64_t signed_values[] = {-1, 64};
+        BinBuilder(b).uleb128(624485).sleb128(-123456).uleb128(unsigned_values, 3)
+                .sleb128(signed_values, 2);
+        REQUIRE( b.take_output() == text_output("%u624485 %s-123456 %u0 %u300 "
+                "%u18446744073709551615 %s-1 %s64") );
+
+        BinBuilder(b).u8(1).align(4).u8(2).pad_to(8, 0xff).align(0);
+        REQUIRE( b.take_output() == text_output("01 align[4] 02 pad-to[8,ff]") );
+    }
+
+    SECTION("- typed values and text are mixed on the same modes")
+    {
+        BinStream b;
+        b << "big-endian 0011";
+        BinBuilder(b).u16(0x2233).little_endian();
+        b << "4455";
+        REQUIRE( b.endianess() == little_endian );
+        REQUIRE( b.take_output() == text_output("big-endian 0011 2233 little-endian 4455") );
+    }
+
+    SECTION("- the values go to the sink of the stream")
+    {
+        BinStream b;
+        vector<char> out;
+        VectorSink sink(out);
+        b.set_sink(&sink);
+        BinBuilder(b).u32(0x00112233).str("x");
+        REQUIRE( b.size() == 0 );
+        REQUIRE( out == text_output("00112233 'x'") );
+    }
+}
@@ -0,0 +1,136 @@
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "bs_checksum.h"
+
+using namespace std;
+using namespace BS;
+
+namespace
+{
+    // bit by bit computation, independent of the tables and the instructions
+    uint32_t reference_crc(uint32_t poly, const char *data, size_t size)
+    {
+        uint32_t crc = 0xFFFFFFFF;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc ^= (unsigned char)data[i];
+            for (int k = 0; k < 8; ++k)
+            {
+                crc = (crc & 1) ? (crc >> 1) ^ poly : crc >> 1;
+            }
+        }
+        return ~crc;
+    }
+
+    uint32_t reference_adler(const char *data, size_t size)
+    {
+        uint32_t a = 1;
+        uint32_t b = 0;
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            a = (a + (unsigned char)data[i]) % 65521;
+            b = (b + a) % 65521;
+        }
+        return a | (b << 16);
+    }
+}
+
+TEST_CASE("Unit Tests of checksums")
+{
+    vector<char> data(5000);
+    srand(23);
+    for (char & c : data)
+    {
+        c = (char)rand();
+    }
+
+    SECTION("Unit test of 'crc32()', 'crc32c()' and 'adler32()'")
+    {
+        REQUIRE( crc32(0, "123456789", 9) == 0xCBF43926 );
+        REQUIRE( crc32c(0, "123456789", 9) == 0xE3069283 );
+        REQUIRE( adler32(1, "Wikipedia", 9) == 0x11E60398 );
+        REQUIRE( crc32(0, "", 0) == 0 );
+        REQUIRE( adler32(1, "", 0) == 1 );
+
+        // the accelerated paths depend on the size and the alignment
+        for (size_t offset = 0; offset < 16; ++offset)
+        {
+            for (size_t size = 0; size < 1200; size += 1 + size / 8)
+            {
+                const char *p = data.data() + offset;
+                REQUIRE( crc32(0, p, size) == reference_crc(0xEDB88320, p, size) );
+                REQUIRE( crc32c(0, p, size) == reference_crc(0x82F63B78, p, size) );
+                REQUIRE( adler32(1, p, size) == reference_adler(p, size) );
+            }
+        }
+
+        // a checksum continues from the previous value
+        REQUIRE( crc32(crc32(0, data.data(), 1000), data.data() + 1000, 4000) ==
+                crc32(0, data.data(), 5000) );
+        REQUIRE( crc32c(crc32c(0, data.data(), 77), data.data() + 77, 4923) ==
+                crc32c(0, data.data(), 5000) );
+        REQUIRE( adler32(adler32(1, data.data(), 4999), data.data() + 4999, 1) ==
+                adler32(1, data.data(), 5000) );
+    }
+
+    SECTION("Unit test of 'Checksums'")
+    {
+        Checksums all;
+        Checksums prefix;
+        Checksums expected;
+        Checksums filled;
+        string pattern("abc");
+        string repeated;
+
+        all.update(data.data(), data.size());
+        REQUIRE( all.value(t_checksum_crc32) == crc32(0, data.data(), data.size()) );
+        REQUIRE( all.value(t_checksum_crc32c) == crc32c(0, data.data(), data.size()) );
+        REQUIRE( all.value(t_checksum_adler32) == adler32(1, data.data(), data.size()) );
+
+        // the checksums of a part from the checksums of two prefixes
+        prefix.update(data.data(), 1234);
+        expected.update(data.data() + 1234, data.size() - 1234);
+        Checksums suffix = all.suffix(prefix, data.size() - 1234);
+        REQUIRE( suffix.value(t_checksum_crc32) == expected.value(t_checksum_crc32) );
+        REQUIRE( suffix.value(t_checksum_crc32c) == expected.value(t_checksum_crc32c) );
+        REQUIRE( suffix.value(t_checksum_adler32) == expected.value(t_checksum_adler32) );
+
+        // zeros replaced afterwards
+        vector<char> zeros(data);
+        memset(zeros.data() + 3000, 0, 8);
+        Checksums patched;
+        patched.update(zeros.data(), zeros.size());
+        patched.patch(data.data() + 3000, 8, data.size() - 3008);
+        REQUIRE( patched.value(t_checksum_crc32) == all.value(t_checksum_crc32) );
+        REQUIRE( patched.value(t_checksum_crc32c) == all.value(t_checksum_crc32c) );
+        REQUIRE( patched.value(t_checksum_adler32) == all.value(t_checksum_adler32) );
+
+        // large fills are combined instead of gone through
+        for (uint64_t count : {0, 1, 7, 1365, 1366, 100003})
+        {
+            Checksums direct;
+            repeated.clear();
+            for (uint64_t i = 0; i < count; ++i)
+            {
+                repeated += pattern;
+            }
+            filled = Checksums();
+            filled.update("xy", 2);
+            filled.update(pattern.data(), pattern.size(), count);
+            direct.update("xy", 2);
+            direct.update(repeated.data(), repeated.size());
+            REQUIRE( filled.value(t_checksum_crc32) == direct.value(t_checksum_crc32) );
+            REQUIRE( filled.value(t_checksum_crc32c) == direct.value(t_checksum_crc32c) );
+            REQUIRE( filled.value(t_checksum_adler32) == direct.value(t_checksum_adler32) );
+        }
+        filled = Checksums();
+        filled.update("", 0, 1000000);
+        REQUIRE( filled.value(t_checksum_adler32) == 1 );
+    }
+}
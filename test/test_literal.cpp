@@ -0,0 +1,97 @@
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "catch.hpp"
+#include "bs_literal.h"
+#include "BinStream.h"
+
+using namespace std;
+using namespace BS;
+
+template <size_t N>
+static vector<char> bytes(const array<uint8_t, N> & a)
+{
+    return vector<char>(a.begin(), a.end());
+}
+
+static vector<char> text_output(const string & desc)
+{
+    BinStream b;
+    b << desc;
+    return b.take_output();
+}
+
+// evaluated by the compiler
+constexpr auto header = "big-endian 0011 %d42[4] 'abc'"_bin;
+static_assert(header.size() == 9, "a header of 9 bytes");
+static_assert((header[0] == 0x00) && (header[1] == 0x11) && (header[5] == 42) &&
+        (header[6] == 'a'), "the bytes of the header");
+static_assert(literal::measure("size[2] 1 %x1[8]", 16) == 10, "sizes of numbers");
+
+TEST_CASE("Unit Tests of the compile-time descriptions")
+{
+    SECTION("Unit test of '_bin' on integers")
+    {
+        REQUIRE( bytes(header) == text_output("big-endian 0011 %d42[4] 'abc'") );
+        REQUIRE( bytes("00 ff 0102 00112233 0011223344556677 123456789"_bin) ==
+                text_output("00 ff 0102 00112233 0011223344556677 123456789") );
+        REQUIRE( bytes("decimal 1 255 256 65536 4294967296 18446744073709551615 +7"_bin) ==
+                text_output("decimal 1 255 256 65536 4294967296 18446744073709551615 +7") );
+        REQUIRE( bytes("decimal -1 -128 -129 -32769 -2147483649 -0 -9223372036854775808"_bin) ==
+                text_output("decimal -1 -128 -129 -32769 -2147483649 -0 -9223372036854775808") );
+        REQUIRE( bytes("octal 7 777 %o1[8] binary 1 101010101 %b1[2] %d-2[1]"_bin) ==
+                text_output("octal 7 777 %o1[8] binary 1 101010101 %b1[2] %d-2[1]") );
+        REQUIRE( bytes("big-endian size[4] 1 %d1 size[0] 1[2] %x123456789[2] little-endian 0102"_bin) ==
+                text_output("big-endian size[4] 1 %d1 size[0] 1[2] %x123456789[2] little-endian 0102") );
+        REQUIRE( bytes("xsize[2]y 1 size[0]"_bin) == text_output("xsize[2]y 1 size[0]") );
+    }
+
+    SECTION("Unit test of '_bin' on floats")
+    {
+        REQUIRE( bytes("%f1.5 %f-1.5[8] %f1.2345 %f0.1[8] %f1e10 %f-0 %f0e999 %f3[0] %f2[2]"_bin) ==
+                text_output("%f1.5 %f-1.5[8] %f1.2345 %f0.1[8] %f1e10 %f-0 %f0e999 %f3[0] %f2[2]") );
+        REQUIRE( bytes("big-endian float 1.5 123456.789[8] 1E-10 0.5 -2.5e+3[8]"_bin) ==
+                text_output("big-endian float 1.5 123456.789[8] 1E-10 0.5 -2.5e+3[8]") );
+    }
+
+    SECTION("Unit test of '_bin' on lines")
+    {
+        auto desc = "# comment 00\n  'a string line with spaces'  \n\n\t 01 02\n\"x\" 'y' 03\n04"_bin;
+        REQUIRE( bytes(desc) == text_output(
+                "# comment 00\n  'a string line with spaces'  \n\n\t 01 02\n\"x\" 'y' 03\n04") );
+        REQUIRE( ""_bin.size() == 0 );
+    }
+
+    SECTION("Unit test of '_bin' on repeat and fill")
+    {
+        REQUIRE( bytes("repeat[3] 0102 big-endian repeat[2] %d300[4] fill[3] repeat[0] 'x'"_bin) ==
+                text_output("repeat[3] 0102 big-endian repeat[2] %d300[4] fill[3] repeat[0] 'x'") );
+        REQUIRE( bytes("repeat[2]\n'a b'\nrepeat[2] fill[2] 'c' repeat[1] 01"_bin) ==
+                text_output("repeat[2]\n'a b'\nrepeat[2] fill[2] 'c' repeat[1] 01") );
+        static_assert(literal::measure("fill[1000] repeat[1000] 0102", 28) == 3000, "repeated sizes");
+        REQUIRE( bytes("%u624485 %s-123456 %u1[3] %s-1[3] %s64 repeat[2] %u128 "
+                "%u18446744073709551615 %s-9223372036854775808"_bin) ==
+                text_output("%u624485 %s-123456 %u1[3] %s-1[3] %s64 repeat[2] %u128 "
+                "%u18446744073709551615 %s-9223372036854775808") );
+        REQUIRE( bytes("01 align[4] 02 align[4,ff] pad-to[12,aa] align[8] 03"_bin) ==
+                text_output("01 align[4] 02 align[4,ff] pad-to[12,aa] align[8] 03") );
+    }
+
+    SECTION("- a malformed description raises an exception at run time")
+    {
+        const char *bad[] = {"zz", "%q12", "%x", "size[3]", "%d1[3]", "1[2",
+                "decimal 18446744073709551616", "decimal -9223372036854775809",
+                "%x10000000000000000", "%f1e30", "%f0.1e-30[8]", "%f1.5e", "align[0]",
+                "fill[5] pad-to[3]", "%u128[1]", "%u-1", "%u1[11]", "%s1x",
+                "%u18446744073709551616", "%s9223372036854775808", "01 repeat[2]",
+                "repeat[2] align[4]", "repeat[0] pad-to[4]"};
+
+        for (const char *desc : bad)
+        {
+            REQUIRE_THROWS_AS( literal::encode<16>(desc, string(desc).size()),
+                    const std::invalid_argument & );
+        }
+    }
+}
@@ -0,0 +1,238 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "pipeline.h"
+#include "spsc_ring.h"
+#include "BinStream.h"
+#include "bs_sink.h"
+#include "bs_exception.h"
+
+using namespace std;
+using namespace BS;
+
+static string make_description(int lines)
+{
+    const char *elements[] = {
+        "00", "%xff", "0102", "%d-300", "%f1.5[8]", "big-endian",
+        "little-endian", "decimal", "hex", "17", "size[2]", "size[0]"
+    };
+    string desc;
+    unsigned seed = 7;
+
+    for (int line = 0; line < lines; ++line)
+    {
+        for (int i = 0; i < 5; ++i)
+        {
+            seed = seed * 1103515245 + 12345;
+            desc += elements[(seed >> 16) % (sizeof(elements) / sizeof(*elements))];
+            desc += ' ';
+        }
+        desc += '\n';
+        if (line % 7 == 0)
+        {
+            desc += (line % 14 == 0) ? "# comment hex\n" : "'line string'\n";
+        }
+    }
+    return desc;
+}
+
+static int temp_input(FILE *f, const string & content)
+{
+    fwrite(content.data(), 1, content.size(), f);
+    fflush(f);
+    rewind(f);
+    return fileno(f);
+}
+
+TEST_CASE("Unit Tests of the single producer single consumer ring")
+{
+    SECTION("Unit test of 'push()' and 'pop()'")
+    {
+        SpscRing<int> ring(3);
+        int value;
+
+        REQUIRE( ring.capacity() == 4 );
+        REQUIRE( ring.pop(value) == false );
+        for (int i = 0; i < 4; ++i)
+        {
+            REQUIRE( ring.push(i) );
+        }
+        REQUIRE( ring.push(4) == false );
+        REQUIRE( ring.pop(value) );
+        REQUIRE( value == 0 );
+        REQUIRE( ring.push(4) );
+        for (int i = 1; i < 5; ++i)
+        {
+            REQUIRE( ring.pop(value) );
+            REQUIRE( value == i );
+        }
+        REQUIRE( ring.pop(value) == false );
+    }
+
+    SECTION("- the values are passed in order between two threads")
+    {
+        SpscRing<int> ring(8);
+        const int count = 100000;
+        int value;
+        int expected = 0;
+        bool ordered = true;
+
+        thread producer([&ring]() {
+            for (int i = 0; i < count; ++i)
+            {
+                while (!ring.push(i))
+                {
+                    this_thread::yield();
+                }
+            }
+        });
+        while (expected < count)
+        {
+            if (ring.pop(value))
+            {
+                ordered = ordered && (value == expected);
+                ++expected;
+            }
+        }
+        producer.join();
+        REQUIRE( ordered );
+    }
+}
+
+TEST_CASE("Unit Tests of the conversion pipeline")
+{
+    string desc = make_description(5000);
+    BinStream serial;
+
+    serial.proceed_input(desc.data(), desc.size());
+
+    SECTION("Unit test of 'run()' reading a pipe")
+    {
+        int fds[2];
+        REQUIRE( pipe(fds) == 0 );
+        thread feeder([&desc, &fds]() {
+            size_t done = 0;
+            ssize_t n;
+            while (done < desc.size())
+            {
+                n = write(fds[1], desc.data() + done, min((size_t)1000, desc.size() - done));
+                if (n <= 0)
+                {
+                    break;
+                }
+                done += n;
+            }
+            close(fds[1]);
+        });
+        BinStream b;
+        vector<char> output;
+        VectorSink sink(output);
+
+        Pipeline(4096, 3).run(b, fds[0], sink);
+        feeder.join();
+        close(fds[0]);
+        REQUIRE( output.size() == serial.size() );
+        REQUIRE( memcmp(output.data(), serial.data(), serial.size()) == 0 );
+        REQUIRE( b.errors() == serial.errors() );
+        // the BinStream gets back its own output
+        b << "size[0] %xff";
+        REQUIRE( b.size() == 1 );
+    }
+
+    SECTION("- chunks smaller than the lines")
+    {
+        FILE *f = tmpfile();
+        REQUIRE( f != NULL );
+        int fd = temp_input(f, desc + "'last line without end'");
+        BinStream b;
+        vector<char> output;
+        VectorSink sink(output);
+
+        serial << "'last line without end'";
+        Pipeline(7, 1).run(b, fd, sink);
+        fclose(f);
+        REQUIRE( string(output.begin(), output.end())
+                == string(serial.data(), serial.size()) );
+    }
+
+    SECTION("- a forward reference is patched across the chunks")
+    {
+        FILE *f = tmpfile();
+        REQUIRE( f != NULL );
+        string labeled = "big-endian @end 'x'\n:start\n" + desc + "big-endian\n:end\n@end-start\n";
+        int fd = temp_input(f, labeled);
+        BinStream b;
+        BinStream expected;
+        vector<char> output;
+        VectorSink sink(output);
+
+        expected << labeled;
+        Pipeline(4096, 2).run(b, fd, sink);
+        fclose(f);
+        REQUIRE( b.unresolved() == 0 );
+        REQUIRE( output == expected.take_output() );
+        REQUIRE( output.size() > 4096 );
+        REQUIRE( output[4] == 'x' );
+    }
+
+    SECTION("- an empty input gives an empty output")
+    {
+        FILE *f = tmpfile();
+        REQUIRE( f != NULL );
+        int fd = temp_input(f, "");
+        BinStream b;
+        vector<char> output;
+        VectorSink sink(output);
+
+        Pipeline().run(b, fd, sink);
+        fclose(f);
+        REQUIRE( output.empty() );
+    }
+
+    SECTION("- an exception of the parser stops the pipeline")
+    {
+        FILE *f = tmpfile();
+        REQUIRE( f != NULL );
+        int fd = temp_input(f, desc + "size[0] decimal 99999999999999999999999\n" + desc);
+        BinStream b;
+        vector<char> output;
+        VectorSink sink(output);
+
+        REQUIRE_THROWS_AS( Pipeline(4096, 2).run(b, fd, sink), const std::out_of_range & );
+        fclose(f);
+        REQUIRE( output.size() <= serial.size() );
+    }
+
+    SECTION("- an exception of the sink stops the pipeline")
+    {
+        FILE *f = tmpfile();
+        REQUIRE( f != NULL );
+        int fd = temp_input(f, desc);
+        BinStream b;
+        char buffer[100];
+        FixedBufferSink sink(buffer, sizeof(buffer));
+
+        REQUIRE_THROWS_AS( Pipeline(4096, 2).run(b, fd, sink), const BSExceptionSinkFull & );
+        fclose(f);
+    }
+
+    SECTION("- an unreadable input raises an exception")
+    {
+        int fd = open(".", O_RDONLY);
+        REQUIRE( fd >= 0 );
+        BinStream b;
+        vector<char> output;
+        VectorSink sink(output);
+
+        // a directory is ready but cannot be read
+        REQUIRE_THROWS_AS( Pipeline().run(b, fd, sink), const BSExceptionReadFailed & );
+        close(fd);
+    }
+}
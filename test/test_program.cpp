@@ -0,0 +1,119 @@
+#include <string>
+#include <vector>
+#include <thread>
+
+#include "catch.hpp"
+#include "BinStream.h"
+
+using namespace std;
+using namespace BS;
+
+TEST_CASE("Unit Tests of compiled programs")
+{
+    string desc("big-endian 0011 'abc'\ndecimal 300\nlittle-endian size[4] 7");
+    BinStream ref;
+    vector<char> expected;
+    ref << desc;
+    ref >> expected;
+
+    SECTION("Unit test of 'compile()'")
+    {
+        BinStream b;
+        Program program = b.compile(desc);
+        REQUIRE( program.size() == expected.size() );
+        REQUIRE( program.bytes() == expected );
+        REQUIRE( b.output_ready() == false );
+
+        // literal bytes are merged in runs between mode changes
+        REQUIRE( program.ops().size() == 7 );
+        REQUIRE( program.ops()[0].code == Program::op_endianess );
+        REQUIRE( program.ops()[1].code == Program::op_bytes );
+        REQUIRE( program.ops()[1].length == 5 );
+    }
+
+    SECTION("Unit test of 'Program::run()'")
+    {
+        Program program = BinStream().compile(desc);
+        vector<char> output;
+        VectorSink sink(output);
+
+        program.run(sink);
+        program.run(sink);
+        REQUIRE( output.size() == 2 * expected.size() );
+        REQUIRE( vector<char>(output.begin(), output.begin() + expected.size()) == expected );
+        REQUIRE( vector<char>(output.begin() + expected.size(), output.end()) == expected );
+    }
+
+    SECTION("Unit test of 'BinStream::run()' which applies the modes")
+    {
+        BinStream b;
+        vector<char> output;
+        Program program = b.compile(desc);
+
+        b.run(program) << "10";
+        ref << "10";
+        b >> output;
+        ref >> expected;
+        REQUIRE( output == expected );
+    }
+
+    SECTION("A fill is stored once")
+    {
+        BinStream b;
+        Program program = b.compile("00 fill[1000000] repeat[3] 'ab' 01");
+        vector<char> output;
+        VectorSink sink(output);
+
+        REQUIRE( program.size() == 1000008 );
+        REQUIRE( program.bytes().size() == 5 );
+        REQUIRE( program.ops().size() == 4 );
+        REQUIRE( program.ops()[1].code == Program::op_fill );
+        REQUIRE( program.ops()[1].count == 1000000 );
+
+        program.run(sink);
+        b.run(program);
+        REQUIRE( output.size() == 1000008 );
+        REQUIRE( b.take_output() == output );
+        REQUIRE( string(output.end() - 7, output.end()) == string("ababab\x01") );
+    }
+
+    SECTION("A forward reference is patched in the program")
+    {
+        BinStream b;
+        Program program = b.compile("@end[2] fill[3] 'ab'\n:end\n@end[1]");
+        vector<char> output;
+        VectorSink sink(output);
+
+        program.run(sink);
+        REQUIRE( output == vector<char>({7, 0, 0, 0, 0, 'a', 'b', 7}) );
+
+        program = b.compile("@end[2] big-endian @end[2] 0001\n:end");
+        REQUIRE( program.bytes() == vector<char>({6, 0, 0, 6, 0, 1}) );
+    }
+
+    SECTION("A program is run concurrently")
+    {
+        const Program program = BinStream().compile(desc);
+        vector<vector<char> > outputs(4);
+        vector<thread> workers;
+
+        for (size_t i = 0; i < outputs.size(); ++i)
+        {
+            workers.push_back(thread([&program, &outputs, i]() {
+                VectorSink sink(outputs[i]);
+                for (int n = 0; n < 100; ++n)
+                {
+                    program.run(sink);
+                }
+            }));
+        }
+        for (thread & worker : workers)
+        {
+            worker.join();
+        }
+        for (const vector<char> & output : outputs)
+        {
+            REQUIRE( output.size() == 100 * expected.size() );
+        }
+    }
+}
@@ -0,0 +1,216 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <unistd.h>
+
+#include "catch.hpp"
+#include "BinStream.h"
+
+using namespace std;
+using namespace BS;
+
+TEST_CASE("Unit Tests of sinks")
+{
+    SECTION("Unit test of 'VectorSink'")
+    {
+        vector<char> v(1, 'x');
+        VectorSink sink(v);
+        BinStream b;
+
+        b.set_sink(&sink);
+        b << "big-endian 0001 'ab'";
+        REQUIRE( v == vector<char>({'x', 0x00, 0x01, 'a', 'b'}) );
+        REQUIRE( b.output_ready() == false );
+        REQUIRE( b.size() == 0 );
+
+        b.set_sink(NULL);
+        b << "02";
+        REQUIRE( b.size() == 1 );
+        REQUIRE( v.size() == 5 );
+    }
+
+    SECTION("Unit test of 'FixedBufferSink'")
+    {
+        char buffer[4];
+        FixedBufferSink sink(buffer, sizeof(buffer));
+        BinStream b;
+
+        b.set_sink(&sink);
+        b << "00 01 02";
+        REQUIRE( sink.size() == 3 );
+        REQUIRE( buffer[0] == 0x00 );
+        REQUIRE( buffer[2] == 0x02 );
+        REQUIRE_THROWS_AS( b << "0304", const BSExceptionSinkFull & );
+        REQUIRE( sink.size() == 3 );
+    }
+
+    SECTION("Unit test of 'FdSink'")
+    {
+        int fds[2];
+        char buffer[16];
+
+        REQUIRE( pipe(fds) == 0 );
+        {
+            FdSink sink(fds[1], 4);
+            BinStream b;
+            b.set_sink(&sink);
+            b << "'abc'";
+            b << "'defgh'";
+            b << "'ij'";
+        }
+        close(fds[1]);
+        REQUIRE( read(fds[0], buffer, sizeof(buffer)) == 10 );
+        REQUIRE( string(buffer, 10) == "abcdefghij" );
+        close(fds[0]);
+
+        FdSink bad_sink(-1);
+        bad_sink.write("a", 1);
+        REQUIRE_THROWS_AS( bad_sink.flush(), const BSExceptionWriteFailed & );
+    }
+
+    SECTION("Unit test of 'MappedFileSink'")
+    {
+        char path[] = "/tmp/binmake_testXXXXXX";
+        char buffer[16];
+        int fd = mkstemp(path);
+        REQUIRE( fd >= 0 );
+        {
+            MappedFileSink sink(fd, 2);
+            BinStream b;
+            b.set_sink(&sink);
+            b << "'abc'" << "'defgh'";
+            REQUIRE( sink.size() == 8 );
+            sink.close();
+        }
+        REQUIRE( lseek(fd, 0, SEEK_END) == 8 );
+        REQUIRE( pread(fd, buffer, sizeof(buffer), 0) == 8 );
+        REQUIRE( string(buffer, 8) == "abcdefgh" );
+        close(fd);
+        unlink(path);
+    }
+
+    SECTION("Unit test of 'CallbackSink'")
+    {
+        string received;
+        CallbackSink sink([&received](const char *data, size_t size) {
+            received.append(data, size);
+        });
+        BinStream b;
+        stringstream in("'hello'\n%x2021");
+
+        b.stream(in, sink);
+        REQUIRE( received == string("hello\x21\x20") );
+    }
+
+    SECTION("Unit test of 'fill()'")
+    {
+        vector<char> v(1, 'a');
+        VectorSink vector_sink(v);
+        vector_sink.fill("bc", 2, 3);
+        vector_sink.fill("d", 1, 2);
+        vector_sink.fill("e", 1, 0);
+        REQUIRE( string(v.data(), v.size()) == "abcbcbcdd" );
+
+        char buffer[4];
+        FixedBufferSink fixed_sink(buffer, sizeof(buffer));
+        fixed_sink.fill("xyz", 3, 1);
+        REQUIRE_THROWS_AS( fixed_sink.fill("x", 1, 2), const BSExceptionSinkFull & );
+        REQUIRE( fixed_sink.size() == 3 );
+
+        // the default fill writes blocks
+        string received;
+        size_t writes = 0;
+        CallbackSink callback_sink([&received, &writes](const char *data, size_t size) {
+            received.append(data, size);
+            ++writes;
+        });
+        callback_sink.fill("ab", 2, 3 * Sink::FILL_BLOCK_SIZE / 2);
+        REQUIRE( received.size() == 3 * Sink::FILL_BLOCK_SIZE );
+        REQUIRE( received.compare(received.size() - 4, 4, "abab") == 0 );
+        REQUIRE( writes == 3 );
+
+        CountingSink counting_sink;
+        counting_sink.fill("abc", 3, 1000000000000ULL);
+        REQUIRE( counting_sink.size() == 3000000000000ULL );
+    }
+
+    SECTION("Unit test of 'patch()'")
+    {
+        vector<char> v(1, 'a');
+        VectorSink vector_sink(v);
+        vector_sink.write("bcde", 4);
+        vector_sink.patch(3, "XY", 2);
+        REQUIRE( string(v.data(), v.size()) == "abXYe" );
+        REQUIRE_THROWS_AS( vector_sink.patch(6, "X", 1), const BSExceptionPatchFailed & );
+        REQUIRE_THROWS_AS( vector_sink.patch(1, "XY", 2), const BSExceptionPatchFailed & );
+
+        char buffer[4];
+        FixedBufferSink fixed_sink(buffer, sizeof(buffer));
+        fixed_sink.write("xyz", 3);
+        fixed_sink.patch(3, "X", 1);
+        REQUIRE( string(buffer, 3) == "Xyz" );
+
+        // patched in the buffer, then in the file once flushed
+        char path[] = "/tmp/binmake_testXXXXXX";
+        int fd = mkstemp(path);
+        REQUIRE( fd >= 0 );
+        {
+            FdSink fd_sink(fd, 4);
+            fd_sink.write("abc", 3);
+            fd_sink.patch(2, "B", 1);
+            fd_sink.write("defgh", 5);
+            fd_sink.patch(8, "A", 1);
+        }
+        REQUIRE( pread(fd, buffer, sizeof(buffer), 0) == 4 );
+        REQUIRE( string(buffer, 4) == "ABcd" );
+        close(fd);
+        unlink(path);
+
+        // a pipe cannot seek
+        int fds[2];
+        REQUIRE( pipe(fds) == 0 );
+        {
+            FdSink pipe_sink(fds[1], 2);
+            pipe_sink.write("abcd", 4);
+            REQUIRE_THROWS_AS( pipe_sink.patch(4, "A", 1), const BSExceptionPatchFailed & );
+        }
+        close(fds[0]);
+        close(fds[1]);
+
+        stringstream stream;
+        StreamSink stream_sink(stream);
+        stream_sink.write("abc", 3);
+        stream_sink.patch(3, "A", 1);
+        stream_sink.write("d", 1);
+        REQUIRE( stream.str() == "Abcd" );
+
+        CallbackSink callback_sink([](const char *, size_t) {});
+        callback_sink.write("abc", 3);
+        REQUIRE_THROWS_AS( callback_sink.patch(3, "A", 1), const BSExceptionPatchFailed & );
+    }
+
+    SECTION("Unit test of 'prepare()' and 'commit()'")
+    {
+        vector<char> v(1, 'a');
+        VectorSink vector_sink(v);
+        memcpy(vector_sink.prepare(4), "bcde", 4);
+        vector_sink.commit(2);
+        REQUIRE( string(v.data(), v.size()) == "abc" );
+
+        char buffer[4];
+        FixedBufferSink fixed_sink(buffer, sizeof(buffer));
+        memcpy(fixed_sink.prepare(3), "xyz", 3);
+        fixed_sink.commit(3);
+        REQUIRE( fixed_sink.size() == 3 );
+        REQUIRE_THROWS_AS( fixed_sink.prepare(2), const BSExceptionSinkFull & );
+
+        string received;
+        CallbackSink callback_sink([&received](const char *data, size_t size) {
+            received.append(data, size);
+        });
+        memcpy(callback_sink.prepare(5), "hello", 5);
+        callback_sink.commit(5);
+        REQUIRE( received == "hello" );
+    }
+}
@@ -0,0 +1,86 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "catch.hpp"
+#include "work_pool.h"
+#include "BinStream.h"
+
+using namespace std;
+using namespace BS;
+
+TEST_CASE("Unit Tests of the pool of threads")
+{
+    SECTION("Unit test of 'run()'")
+    {
+        for (size_t threads : {1, 2, 3, 8})
+        {
+            WorkPool pool(threads);
+            REQUIRE( pool.threads() == threads );
+            for (size_t count : {0, 1, 5, 100})
+            {
+                vector<atomic<int> > done(count);
+                pool.run(count, [&done](size_t i) {
+                    ++done[i];
+                });
+                for (size_t i = 0; i < count; ++i)
+                {
+                    REQUIRE( done[i] == 1 );
+                }
+            }
+        }
+        REQUIRE( WorkPool().threads() > 0 );
+    }
+
+    SECTION("- idle threads steal the tasks of a busy one")
+    {
+        WorkPool pool(2);
+        atomic<int> count(0);
+        vector<thread::id> ids(4);
+
+        // tasks 0 and 1 are dealt to the first thread, task 0 is long
+        pool.run(4, [&](size_t i) {
+            if (i == 0)
+            {
+                this_thread::sleep_for(chrono::milliseconds(200));
+            }
+            ids[i] = this_thread::get_id();
+            ++count;
+        });
+        REQUIRE( count == 4 );
+        REQUIRE( ids[1] != ids[0] );
+    }
+
+    SECTION("- an exception is raised again once all tasks are done")
+    {
+        WorkPool pool(4);
+        atomic<int> count(0);
+
+        REQUIRE_THROWS_AS( pool.run(20, [&count](size_t i) {
+            ++count;
+            if (i == 3)
+            {
+                throw runtime_error("task failed");
+            }
+        }), const runtime_error & );
+        REQUIRE( count == 20 );
+    }
+
+    SECTION("- each task uses its own BinStream")
+    {
+        WorkPool pool(4);
+        vector<vector<char> > outputs(50);
+
+        pool.run(outputs.size(), [&outputs](size_t i) {
+            BinStream b;
+            b << "decimal big-endian" << "%d" + to_string(i) + "[4]";
+            outputs[i] = b.take_output();
+        });
+        for (size_t i = 0; i < outputs.size(); ++i)
+        {
+            REQUIRE( outputs[i] == vector<char>({0, 0, 0, (char)i}) );
+        }
+    }
+}